@@ -9,9 +9,16 @@
 #define __EEPROM_H
 
 
+#define EEPROM_TOTAL_SIZE 1024
+#define EEPROM_PAGE_SIZE    16
+
+/* page write cycle, the device does not acknowledge meanwhile */
+#define EEPROM_WRITE_CYCLE_MS 5
+
 void eeprom_init (void);
 int16_t eeprom_read(uint8_t* buf, uint16_t offset, uint16_t len);
 int16_t eeprom_write(uint8_t* buf, uint16_t offset, uint16_t len);
+int16_t eeprom_writePage(uint8_t* buf, uint16_t offset, uint16_t len);
 
 
 #endif /* end __EEPROM_H */
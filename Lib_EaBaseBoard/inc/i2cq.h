@@ -0,0 +1,44 @@
+/*****************************************************************************
+ *   i2cq.h:  Header file for the interrupt driven I2C2 transaction queue
+ *
+******************************************************************************/
+#ifndef __I2CQ_H
+#define __I2CQ_H
+
+#define I2CQ_CLOCK_STANDARD 100000
+#define I2CQ_CLOCK_FAST     400000
+
+/* number of queued transactions */
+#define I2CQ_DEPTH   8
+
+/* largest write copied into the queue: an EEPROM page plus its offset */
+#define I2CQ_TX_MAX  17
+
+/* completion callback, called from the I2C interrupt. result is 0 on
+   success and -1 when the transfer failed after all retries */
+typedef void (*i2cq_callback_t)(void *arg, int result);
+
+/* queue statistics */
+typedef struct
+{
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t errors;
+    uint32_t maxDepth;
+    uint32_t waits;      /* submits that had to wait for a free slot */
+} i2cq_stats_t;
+
+void i2cq_init(uint32_t clockrate);
+int i2cq_submit(uint8_t addr, uint8_t *txBuf, uint32_t txLen,
+        uint8_t *rxBuf, uint32_t rxLen, i2cq_callback_t cb, void *arg);
+int i2cq_write(uint8_t addr, uint8_t *buf, uint32_t len);
+int i2cq_transfer(uint8_t addr, uint8_t *txBuf, uint32_t txLen,
+        uint8_t *rxBuf, uint32_t rxLen);
+uint8_t i2cq_busy(void);
+void i2cq_getStats(i2cq_stats_t *pStats);
+
+
+#endif /* end __I2CQ_H */
+/****************************************************************************
+**                            End Of File
+*****************************************************************************/
@@ -18,6 +18,28 @@ typedef enum
     OLED_COLOR_WHITE
 } oled_color_t;
 
+typedef enum
+{
+    OLED_SCROLL_RIGHT,
+    OLED_SCROLL_LEFT
+} oled_scroll_dir_t;
+
+/* SPI transfer statistics */
+typedef struct
+{
+    uint32_t transactions;
+    uint32_t bytes;
+} oled_stats_t;
+
+/* number of frames between each scroll step */
+typedef enum
+{
+    OLED_SCROLL_6_FRAMES,
+    OLED_SCROLL_32_FRAMES,
+    OLED_SCROLL_64_FRAMES,
+    OLED_SCROLL_128_FRAMES
+} oled_scroll_speed_t;
+
 
 void oled_init (void);
 void oled_putPixel(uint8_t x, uint8_t y, oled_color_t color);
@@ -29,6 +51,28 @@ void oled_clearScreen(oled_color_t color);
 void oled_putString(uint8_t x, uint8_t y, uint8_t *pStr, oled_color_t fb,
         oled_color_t bg);
 uint8_t oled_putChar(uint8_t x, uint8_t y, uint8_t ch, oled_color_t fb, oled_color_t bg);
+uint8_t oled_putStringLine(uint8_t y, uint8_t *pStr, oled_color_t fb,
+        oled_color_t bg);
+uint8_t oled_putCharLine(uint8_t x, uint8_t y, uint8_t ch, oled_color_t fb,
+        oled_color_t bg);
+void oled_putColumns(uint8_t x, uint8_t y, uint8_t *data, uint8_t len);
+
+void oled_setStartLine(uint8_t line);
+uint8_t oled_getStartLine(void);
+void oled_scrollHorizontal(uint8_t y0, uint8_t y1, oled_scroll_dir_t dir,
+        oled_scroll_speed_t speed);
+void oled_scrollVertical(uint8_t fixedRows, uint8_t offset,
+        oled_scroll_speed_t speed);
+void oled_scrollStop(void);
+
+void oled_getStats(oled_stats_t *pStats);
+void oled_resetStats(void);
+
+#ifdef OLED_USE_CAPTURE
+oled_color_t oled_captureGetPixel(uint8_t x, uint8_t y);
+int oled_captureWritePbm(const char *path);
+int oled_captureWritePng(const char *path);
+#endif
 
 
 #endif /* end __OLED_H */
@@ -48,6 +48,14 @@
 #define LED18 0x4000
 #define LED19 0x8000
 
+/* register write statistics */
+typedef struct
+{
+    uint32_t writes;
+    uint32_t bytes;
+    uint32_t skipped;
+} pca9532_stats_t;
+
 
 void pca9532_init (void);
 uint16_t pca9532_getLedState (uint32_t shadow);
@@ -58,6 +66,10 @@ void pca9532_setBlink0Leds(uint16_t ledMask);
 void pca9532_setBlink1Period(uint8_t period);
 void pca9532_setBlink1Duty(uint8_t duty);
 void pca9532_setBlink1Leds(uint16_t ledMask);
+void pca9532_setBlink0Pwm(uint8_t pwm);
+void pca9532_setDeferred(uint8_t on);
+void pca9532_flush(void);
+void pca9532_getStats(pca9532_stats_t *pStats);
 
 #endif /* end __PCA9532C_H */
 /****************************************************************************
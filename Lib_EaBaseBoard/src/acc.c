@@ -7,8 +7,8 @@
  ******************************************************************************/
 
 /*
- * NOTE: I2C must have been initialized before calling any functions in this
- * file.
+ * NOTE: I2C must have been initialized (i2cq_init) before calling any
+ * functions in this file.
  */
 
 /******************************************************************************
@@ -16,13 +16,12 @@
  *****************************************************************************/
 
 #include "lpc17xx_i2c.h"
+#include "i2cq.h"
 #include "acc.h"
 
 /******************************************************************************
  * Defines and typedefs
  *****************************************************************************/
-#define I2CDEV LPC_I2C2
-
 #define ACC_I2C_ADDR    (0x1D)
 
 #define ACC_ADDR_XOUTL  0x00
@@ -75,38 +74,14 @@
 
 static int I2CRead(uint8_t addr, uint8_t* buf, uint32_t len)
 {
-	I2C_M_SETUP_Type rxsetup;
-
-	rxsetup.sl_addr7bit = addr;
-	rxsetup.tx_data = NULL;	// Get address to read at writing address
-	rxsetup.tx_length = 0;
-	rxsetup.rx_data = buf;
-	rxsetup.rx_length = len;
-	rxsetup.retransmissions_max = 3;
-
-	if (I2C_MasterTransferData(I2CDEV, &rxsetup, I2C_TRANSFER_POLLING) == SUCCESS){
-		return (0);
-	} else {
-		return (-1);
-	}
+	/* waits for earlier queued writes and this read */
+	return i2cq_transfer(addr, NULL, 0, buf, len);
 }
 
 static int I2CWrite(uint8_t addr, uint8_t* buf, uint32_t len)
 {
-	I2C_M_SETUP_Type txsetup;
-
-	txsetup.sl_addr7bit = addr;
-	txsetup.tx_data = buf;
-	txsetup.tx_length = len;
-	txsetup.rx_data = NULL;
-	txsetup.rx_length = 0;
-	txsetup.retransmissions_max = 3;
-
-	if (I2C_MasterTransferData(I2CDEV, &txsetup, I2C_TRANSFER_POLLING) == SUCCESS){
-		return (0);
-	} else {
-		return (-1);
-	}
+	/* queued, the data is copied and sent from the I2C interrupt */
+	return i2cq_write(addr, buf, len);
 }
 
 
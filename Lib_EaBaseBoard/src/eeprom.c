@@ -7,8 +7,8 @@
  ******************************************************************************/
 
 /*
- * NOTE: I2C must have been initialized before calling any functions in this
- * file.
+ * NOTE: I2C must have been initialized (i2cq_init) before calling any
+ * functions in this file.
  */
 
 /******************************************************************************
@@ -16,6 +16,7 @@
  *****************************************************************************/
 
 #include "lpc17xx_i2c.h"
+#include "i2cq.h"
 #include "string.h"
 #include "stdio.h"
 #include "eeprom.h"
@@ -28,16 +29,12 @@
 #define MIN(x, y) ((x) < (y) ? (x) : (y))
 #endif
 
-#define I2CDEV LPC_I2C2
-
 #define EEPROM_I2C_ADDR1    (0x50)
 #define EEPROM_I2C_ADDR2    (0x51)
 #define EEPROM_I2C_ADDR3    (0x52)
 #define EEPROM_I2C_ADDR4    (0x53)
 
-#define EEPROM_TOTAL_SIZE 1024
 #define EEPROM_BLOCK_SIZE  256
-#define EEPROM_PAGE_SIZE    16
 
 
 /******************************************************************************
@@ -55,38 +52,14 @@
 
 static int I2CRead(uint8_t addr, uint8_t* buf, uint32_t len)
 {
-	I2C_M_SETUP_Type rxsetup;
-
-	rxsetup.sl_addr7bit = addr;
-	rxsetup.tx_data = NULL;	// Get address to read at writing address
-	rxsetup.tx_length = 0;
-	rxsetup.rx_data = buf;
-	rxsetup.rx_length = len;
-	rxsetup.retransmissions_max = 3;
-
-	if (I2C_MasterTransferData(I2CDEV, &rxsetup, I2C_TRANSFER_POLLING) == SUCCESS){
-		return (0);
-	} else {
-		return (-1);
-	}
+	/* waits for earlier queued writes and this read */
+	return i2cq_transfer(addr, NULL, 0, buf, len);
 }
 
 static int I2CWrite(uint8_t addr, uint8_t* buf, uint32_t len)
 {
-	I2C_M_SETUP_Type txsetup;
-
-	txsetup.sl_addr7bit = addr;
-	txsetup.tx_data = buf;
-	txsetup.tx_length = len;
-	txsetup.rx_data = NULL;
-	txsetup.rx_length = 0;
-	txsetup.retransmissions_max = 3;
-
-	if (I2C_MasterTransferData(I2CDEV, &txsetup, I2C_TRANSFER_POLLING) == SUCCESS){
-		return (0);
-	} else {
-		return (-1);
-	}
+	/* blocking: the write cycle delay must start after the transfer */
+	return i2cq_transfer(addr, buf, len, NULL, 0);
 }
 
 
@@ -199,3 +172,41 @@ int16_t eeprom_write(uint8_t* buf, uint16_t offset, uint16_t len)
 
     return written;
 }
+
+/******************************************************************************
+ *
+ * Description:
+ *    Queue a write within one page without waiting for it or for the
+ *    write cycle. The EEPROM does not answer for EEPROM_WRITE_CYCLE_MS
+ *    after the transfer, so the caller must space its accesses.
+ *
+ * Params:
+ *   [in] buf - data to write
+ *   [in] offset - offset to start to write to
+ *   [in] len - number of bytes to write, must not cross a page boundary
+ *
+ * Returns:
+ *   number of queued bytes or -1 in case of an error
+ *
+ *****************************************************************************/
+int16_t eeprom_writePage(uint8_t* buf, uint16_t offset, uint16_t len)
+{
+    uint8_t addr = 0;
+    uint8_t tmp[EEPROM_PAGE_SIZE+1];
+
+    if (len == 0 || offset+len > EEPROM_TOTAL_SIZE
+        || (offset / EEPROM_PAGE_SIZE) != ((offset+len-1) / EEPROM_PAGE_SIZE)) {
+        return -1;
+    }
+
+    addr = EEPROM_I2C_ADDR1 + (offset/EEPROM_BLOCK_SIZE);
+    tmp[0] = offset % EEPROM_BLOCK_SIZE;
+    memcpy(&tmp[1], buf, len);
+
+    /* the queue copies the data, tmp may go out of scope */
+    if (i2cq_write(addr, tmp, len+1) != 0) {
+        return -1;
+    }
+
+    return len;
+}
@@ -0,0 +1,303 @@
+/*****************************************************************************
+ *   i2cq.c:  Interrupt driven transaction queue for the I2C2 bus
+ *
+ ******************************************************************************/
+
+/*
+ * NOTE: The I2C2 pins must have been configured before calling i2cq_init.
+ * Transactions are queued from thread context only; callbacks run in the
+ * I2C2 interrupt and must not submit new transactions.
+ */
+
+/******************************************************************************
+ * Includes
+ *****************************************************************************/
+
+#include "lpc17xx_i2c.h"
+#include "string.h"
+#include "i2cq.h"
+
+/******************************************************************************
+ * Defines and typedefs
+ *****************************************************************************/
+
+#define I2CDEV LPC_I2C2
+#define I2CQ_RETRANSMISSIONS 3
+
+typedef struct
+{
+    I2C_M_SETUP_Type setup;
+    uint8_t txCopy[I2CQ_TX_MAX];
+    i2cq_callback_t cb;
+    void *arg;
+} i2cq_slot_t;
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+
+/* head is written by the submitter, tail by the interrupt */
+static i2cq_slot_t slots[I2CQ_DEPTH];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+static volatile uint8_t active = 0;
+
+static i2cq_stats_t stats;
+
+
+/******************************************************************************
+ * Local Functions
+ *****************************************************************************/
+
+static uint8_t depth(void)
+{
+    return (uint8_t)((head + I2CQ_DEPTH - tail) % I2CQ_DEPTH);
+}
+
+/* Start the transaction at tail. Called with the I2C2 interrupt masked or
+   from the interrupt itself */
+static void startNext(void)
+{
+    if (tail == head) {
+        active = 0;
+        return;
+    }
+
+    active = 1;
+    slots[tail].setup.retransmissions_count = 0;
+    I2C_MasterTransferData(I2CDEV, &slots[tail].setup, I2C_TRANSFER_INTERRUPT);
+}
+
+static void doneFlag(void *arg, int result)
+{
+    *(volatile int *)arg = result;
+}
+
+
+/******************************************************************************
+ * Public Functions
+ *****************************************************************************/
+
+/******************************************************************************
+ *
+ * Description:
+ *    Initialize the I2C2 controller and the transaction queue
+ *
+ * Params:
+ *   [in] clockrate - bus clock, I2CQ_CLOCK_STANDARD or I2CQ_CLOCK_FAST
+ *
+ *****************************************************************************/
+void i2cq_init(uint32_t clockrate)
+{
+    head = 0;
+    tail = 0;
+    active = 0;
+    memset(&stats, 0, sizeof(stats));
+
+    I2C_Init(I2CDEV, clockrate);
+    I2C_Cmd(I2CDEV, ENABLE);
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Queue a transaction: an optional write followed by an optional read
+ *    with a repeated start. Write data up to I2CQ_TX_MAX bytes is copied,
+ *    so the caller's buffer can be reused at once. Waits for a free slot
+ *    when the queue is full.
+ *
+ * Params:
+ *   [in] addr - 7-bit slave address
+ *   [in] txBuf - data to write, NULL if none
+ *   [in] txLen - number of bytes to write
+ *   [out] rxBuf - read buffer, must stay valid until the callback
+ *   [in] rxLen - number of bytes to read
+ *   [in] cb - completion callback, may be NULL
+ *   [in] arg - argument passed to the callback
+ *
+ * Returns:
+ *   0 when queued, -1 if the write is too long to be copied
+ *
+ *****************************************************************************/
+int i2cq_submit(uint8_t addr, uint8_t *txBuf, uint32_t txLen,
+        uint8_t *rxBuf, uint32_t rxLen, i2cq_callback_t cb, void *arg)
+{
+    i2cq_slot_t *s;
+    uint8_t next;
+    uint8_t d;
+
+    if (txLen > I2CQ_TX_MAX) {
+        return -1;
+    }
+
+    next = (head + 1) % I2CQ_DEPTH;
+    if (next == tail) {
+        stats.waits++;
+        while (next == tail) {
+            /* the interrupt frees slots */
+        }
+    }
+
+    s = &slots[head];
+    if (txLen > 0) {
+        memcpy(s->txCopy, txBuf, txLen);
+    }
+    s->setup.sl_addr7bit = addr;
+    s->setup.tx_data = (txLen > 0) ? s->txCopy : NULL;
+    s->setup.tx_length = txLen;
+    s->setup.rx_data = rxBuf;
+    s->setup.rx_length = rxLen;
+    s->setup.retransmissions_max = I2CQ_RETRANSMISSIONS;
+    s->setup.callback = NULL;
+    s->cb = cb;
+    s->arg = arg;
+
+    NVIC_DisableIRQ(I2C2_IRQn);
+    head = next;
+    stats.submitted++;
+    d = depth();
+    if (d > stats.maxDepth) {
+        stats.maxDepth = d;
+    }
+    if (!active) {
+        /* enables the interrupt again */
+        startNext();
+    }
+    else {
+        NVIC_EnableIRQ(I2C2_IRQn);
+    }
+
+    return 0;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Queue a write without waiting for it. Writes longer than I2CQ_TX_MAX
+ *    fall back to a blocking transfer.
+ *
+ * Params:
+ *   [in] addr - 7-bit slave address
+ *   [in] buf - data to write
+ *   [in] len - number of bytes to write
+ *
+ * Returns:
+ *   0 when queued or written, -1 on a failed blocking write
+ *
+ *****************************************************************************/
+int i2cq_write(uint8_t addr, uint8_t *buf, uint32_t len)
+{
+    if (len > I2CQ_TX_MAX) {
+        return i2cq_transfer(addr, buf, len, NULL, 0);
+    }
+    return i2cq_submit(addr, buf, len, NULL, 0, NULL, NULL);
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Queue a transaction and wait for it to finish. Earlier queued
+ *    transactions complete first.
+ *
+ * Params:
+ *   [in] addr - 7-bit slave address
+ *   [in] txBuf - data to write, NULL if none
+ *   [in] txLen - number of bytes to write
+ *   [out] rxBuf - read buffer, NULL if none
+ *   [in] rxLen - number of bytes to read
+ *
+ * Returns:
+ *   0 on success, -1 on error
+ *
+ *****************************************************************************/
+int i2cq_transfer(uint8_t addr, uint8_t *txBuf, uint32_t txLen,
+        uint8_t *rxBuf, uint32_t rxLen)
+{
+    volatile int result = 1;
+    I2C_M_SETUP_Type setup;
+
+    if (txLen <= I2CQ_TX_MAX) {
+        i2cq_submit(addr, txBuf, txLen, rxBuf, rxLen, doneFlag, (void *)&result);
+        while (result > 0) {
+            /* wait for the interrupt to complete the transaction */
+        }
+        return result;
+    }
+
+    /* too long to copy: drain the queue and transfer from the caller's buffer */
+    while (active) {
+    }
+    setup.sl_addr7bit = addr;
+    setup.tx_data = txBuf;
+    setup.tx_length = txLen;
+    setup.rx_data = rxBuf;
+    setup.rx_length = rxLen;
+    setup.retransmissions_max = I2CQ_RETRANSMISSIONS;
+    if (I2C_MasterTransferData(I2CDEV, &setup, I2C_TRANSFER_POLLING) == SUCCESS) {
+        return 0;
+    }
+    return -1;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Check if transactions are queued or in progress
+ *
+ * Returns:
+ *   1 if the bus is busy, 0 if the queue is empty
+ *
+ *****************************************************************************/
+uint8_t i2cq_busy(void)
+{
+    return active;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Get the queue statistics
+ *
+ * Params:
+ *   [out] pStats - counters since i2cq_init
+ *
+ *****************************************************************************/
+void i2cq_getStats(i2cq_stats_t *pStats)
+{
+    *pStats = stats;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    I2C2 interrupt: advance the state machine of the current transaction,
+ *    report its result and start the next queued one
+ *
+ *****************************************************************************/
+void I2C2_IRQHandler(void)
+{
+    i2cq_slot_t *s;
+    int result;
+
+    I2C_MasterHandler(I2CDEV);
+    if (!I2C_MasterTransferComplete(I2CDEV)) {
+        return;
+    }
+
+    s = &slots[tail];
+    result = ((s->setup.status & I2C_SETUP_STATUS_DONE) != 0) ? 0 : -1;
+    if (result != 0) {
+        stats.errors++;
+    }
+    stats.completed++;
+
+    tail = (tail + 1) % I2CQ_DEPTH;
+    if (s->cb != NULL) {
+        s->cb(s->arg, result);
+    }
+    startNext();
+}
+
+/****************************************************************************
+**                            End Of File
+*****************************************************************************/
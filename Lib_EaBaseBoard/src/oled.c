@@ -18,6 +18,9 @@
  *****************************************************************************/
 
 #include <string.h>
+#ifdef OLED_USE_CAPTURE
+#include <stdio.h>
+#endif
 #include "lpc17xx_gpio.h"
 #include "lpc17xx_i2c.h"
 #include "lpc17xx_ssp.h"
@@ -30,9 +33,25 @@
 
 //#define OLED_USE_I2C
 
+/*
+ * Define OLED_USE_CAPTURE (e.g. -DOLED_USE_CAPTURE) to build the driver
+ * for a host. SSP and GPIO accesses are then replaced by a capture
+ * backend which decodes the commands and data and reconstructs the
+ * display RAM, see oled_captureGetPixel, oled_captureWritePbm and
+ * oled_captureWritePng.
+ */
+//#define OLED_USE_CAPTURE
+
 #ifdef OLED_USE_I2C
 #define I2CDEV LPC_I2C2
 #define OLED_I2C_ADDR (0x3c)
+#elif defined(OLED_USE_CAPTURE)
+
+#define OLED_CS_OFF()
+#define OLED_CS_ON()
+#define OLED_DATA()   (captureDc = 1)
+#define OLED_CMD()    (captureDc = 0)
+
 #else
 
 #define OLED_CS_OFF() GPIO_SetValue( 0, (1<<6) )
@@ -50,6 +69,21 @@
 
 #define SHADOW_FB_SIZE (OLED_DISPLAY_WIDTH*OLED_DISPLAY_HEIGHT >> 3)
 
+/* number of columns in the controller's display RAM */
+#define RAM_WIDTH 132
+
+#define NUM_PAGES (OLED_DISPLAY_HEIGHT >> 3)
+
+/* SSD1305 scroll commands */
+#define CMD_SCROLL_RIGHT      0x26
+#define CMD_SCROLL_LEFT       0x27
+#define CMD_SCROLL_VERT_RIGHT 0x29
+#define CMD_SCROLL_VERT_LEFT  0x2A
+#define CMD_SCROLL_STOP       0x2E
+#define CMD_SCROLL_START      0x2F
+#define CMD_SCROLL_AREA       0xA3
+#define CMD_START_LINE        0x40
+
 #define setAddress(page,lowerAddr,higherAddr)\
     writeCommand(page);\
     writeCommand(lowerAddr);\
@@ -76,6 +110,30 @@ static uint8_t shadowFB[SHADOW_FB_SIZE];
 
 static uint8_t const  font_mask[8] = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01};
 
+/*
+ * Display start line. All drawing functions take logical coordinates which
+ * are mapped to display RAM rows with this offset, i.e. changing the start
+ * line moves what is already on the display without rewriting it.
+ */
+static uint8_t startLine = 0;
+
+/* pages affected by an active scroll, scrollFirst > scrollLast if none */
+static uint8_t scrollFirst = 1;
+static uint8_t scrollLast  = 0;
+
+/* SPI transfer statistics */
+static oled_stats_t stats = {0, 0};
+
+#ifdef OLED_USE_CAPTURE
+/* reconstructed display RAM and controller state */
+static uint8_t captureRam[NUM_PAGES][RAM_WIDTH];
+static uint8_t captureDc = 0;
+static uint8_t capturePage = 0;
+static uint8_t captureCol = 0;
+static uint8_t captureArgs = 0;
+static uint8_t captureStartLine = 0;
+#endif
+
 
 /******************************************************************************
  * Local Functions
@@ -100,6 +158,102 @@ static int I2CWrite(uint8_t addr, uint8_t* buf, uint32_t len)
 }
 #endif
 
+#ifdef OLED_USE_CAPTURE
+/******************************************************************************
+ *
+ * Description:
+ *    Decode one byte sent to the display controller
+ *
+ * Params:
+ *   [in] data - command or data byte
+ *
+ *****************************************************************************/
+static void
+captureByte(uint8_t data)
+{
+    if (captureDc)
+    {
+        captureRam[capturePage][captureCol] = data;
+        captureCol = (captureCol + 1) % RAM_WIDTH;
+        return;
+    }
+
+    if (captureArgs > 0)
+    {
+        /* argument of a previous command */
+        captureArgs--;
+        return;
+    }
+
+    if (data <= 0x0F)
+    {
+        captureCol = (captureCol & 0xF0) | data;
+    }
+    else if (data <= 0x1F)
+    {
+        captureCol = (captureCol & 0x0F) | ((data & 0x0F) << 4);
+    }
+    else if ((data >= 0x40) && (data <= 0x7F))
+    {
+        captureStartLine = data & 0x3F;
+    }
+    else if ((data >= 0xB0) && (data <= 0xB7))
+    {
+        capturePage = data & 0x07;
+    }
+    else
+    {
+        switch (data)
+        {
+        case 0x81: case 0x82: case 0xA8: case 0xAD: case 0xD3:
+        case 0xD5: case 0xD8: case 0xD9: case 0xDA: case 0xDB:
+            captureArgs = 1;
+            break;
+        case CMD_SCROLL_AREA:
+            captureArgs = 2;
+            break;
+        case 0x91: case CMD_SCROLL_RIGHT: case CMD_SCROLL_LEFT:
+            captureArgs = 4;
+            break;
+        case CMD_SCROLL_VERT_RIGHT: case CMD_SCROLL_VERT_LEFT:
+            captureArgs = 5;
+            break;
+        default:
+            /* commands without arguments */
+            break;
+        }
+    }
+}
+#endif
+
+#ifndef OLED_USE_I2C
+/******************************************************************************
+ *
+ * Description:
+ *    Send a buffer over SSP and update the transfer statistics
+ *
+ * Params:
+ *   [in] xferConfig - transfer setup
+ *
+ *****************************************************************************/
+static void
+sspWrite(SSP_DATA_SETUP_Type *xferConfig)
+{
+#ifdef OLED_USE_CAPTURE
+    uint32_t i;
+
+    for (i = 0; i < xferConfig->length; i++) {
+        captureByte(((uint8_t*)xferConfig->tx_data)[i]);
+    }
+#else
+    SSP_ReadWrite(LPC_SSP1, xferConfig, SSP_TRANSFER_POLLING);
+#endif
+
+    stats.transactions++;
+    stats.bytes += xferConfig->length;
+}
+#endif
+
 /******************************************************************************
  *
  * Description:
@@ -131,7 +285,7 @@ writeCommand(uint8_t data)
 	xferConfig.rx_data = NULL;
 	xferConfig.length  = 1;
 
-    SSP_ReadWrite(LPC_SSP1, &xferConfig, SSP_TRANSFER_POLLING);
+    sspWrite(&xferConfig);
     //SSPSend( (uint8_t *)&data, 1 );
 
     OLED_CS_OFF();
@@ -168,7 +322,7 @@ writeData(uint8_t data)
 	xferConfig.rx_data = NULL;
 	xferConfig.length  = 1;
 
-    SSP_ReadWrite(LPC_SSP1, &xferConfig, SSP_TRANSFER_POLLING);
+    sspWrite(&xferConfig);
     //SSPSend( (uint8_t *)&data, 1 );
 
     OLED_CS_OFF();
@@ -218,7 +372,7 @@ writeDataLen(unsigned char data, unsigned int len)
 	xferConfig.rx_data = NULL;
 	xferConfig.length  = len;
 
-    SSP_ReadWrite(LPC_SSP1, &xferConfig, SSP_TRANSFER_POLLING);
+    sspWrite(&xferConfig);
 
     //SSPSend( (uint8_t *)buf, len );
 
@@ -227,6 +381,113 @@ writeDataLen(unsigned char data, unsigned int len)
 }
 
 
+/******************************************************************************
+ *
+ * Description:
+ *    Write a buffer of data to the display
+ *
+ * Params:
+ *   [in] buf - data to write to the display
+ *   [in] len - number of bytes to write
+ *
+ *****************************************************************************/
+static void
+writeDataBuf(uint8_t *buf, unsigned int len)
+{
+#ifdef OLED_USE_I2C
+    unsigned int i;
+    uint8_t tmp[RAM_WIDTH+1];
+
+    tmp[0] = 0x40; // write Co & D/C bits
+
+    for (i = 0; i < len; i++) {
+        tmp[i+1] = buf[i];
+    }
+
+    I2CWrite(OLED_I2C_ADDR, tmp, len+1);
+
+#else
+    SSP_DATA_SETUP_Type xferConfig;
+
+    OLED_DATA();
+    OLED_CS_ON();
+
+	xferConfig.tx_data = buf;
+	xferConfig.rx_data = NULL;
+	xferConfig.length  = len;
+
+    sspWrite(&xferConfig);
+
+    OLED_CS_OFF();
+#endif
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Get one column (8 vertical pixels) of a character
+ *
+ * Params:
+ *   [in] ch - character
+ *   [in] col - column within the character (0 - 5)
+ *   [in] fb - foreground color
+ *   [in] bg - background color
+ *
+ * Returns:
+ *   Display RAM byte for the column, bit 0 is the top row
+ *
+ *****************************************************************************/
+static uint8_t
+charColumn(uint8_t ch, uint8_t col, oled_color_t fb, oled_color_t bg)
+{
+    uint8_t i = 0;
+    uint8_t data = 0;
+
+    if( (ch < 0x20) || (ch > 0x7f) )
+    {
+        ch = 0x20;      /* unknown character will be set to blank */
+    }
+
+    ch -= 0x20;
+    for(i=0; i<8; i++)
+    {
+        if ( (font5x7[ch][i] & font_mask[col]) != 0 )
+        {
+            if (fb != OLED_COLOR_BLACK)
+                data |= (1 << i);
+        }
+        else if (bg != OLED_COLOR_BLACK)
+        {
+            data |= (1 << i);
+        }
+    }
+
+    return data;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Rewrite a page from the shadow framebuffer. The columns outside of the
+ *    visible area are cleared.
+ *
+ * Params:
+ *   [in] page - page (0 - 7) in display RAM
+ *
+ *****************************************************************************/
+static void
+restorePage(uint8_t page)
+{
+    uint8_t buf[RAM_WIDTH];
+
+    memset(buf, 0, RAM_WIDTH);
+    memcpy(&buf[X_OFFSET], &shadowFB[page*OLED_DISPLAY_WIDTH],
+            OLED_DISPLAY_WIDTH);
+
+    setAddress(0xB0+page, 0x00, 0x10);
+    writeDataBuf(buf, RAM_WIDTH);
+}
+
 /******************************************************************************
  *
  * Description:
@@ -356,6 +617,11 @@ void oled_init (void)
 {
     int i = 0;
 
+#ifdef OLED_USE_CAPTURE
+    memset(captureRam, 0, sizeof(captureRam));
+    captureArgs = 0;
+    (void)i;
+#else
     //GPIO_SetDir(PORT0, 0, 1);
     GPIO_SetDir(2, (1<<1), 1);
     GPIO_SetDir(2, (1<<7), 1);
@@ -363,6 +629,7 @@ void oled_init (void)
 
     /* make sure power is off */
     GPIO_ClearValue( 2, (1<<1) );
+#endif
 
 #ifdef OLED_USE_I2C
     GPIO_ClearValue( 2, (1<<7)); // D/C#
@@ -375,11 +642,13 @@ void oled_init (void)
 
     memset(shadowFB, 0, SHADOW_FB_SIZE);
 
+#ifndef OLED_USE_CAPTURE
     /* small delay before turning on power */
     for (i = 0; i < 0xffff; i++);
 
      /* power on */
     GPIO_SetValue( 2, (1<<1) );
+#endif
 }
 
 /******************************************************************************
@@ -408,6 +677,9 @@ void oled_putPixel(uint8_t x, uint8_t y, oled_color_t color) {
         return;
     }
 
+    /* map to a display RAM row */
+    y = (y + startLine) & (OLED_DISPLAY_HEIGHT-1);
+
     /* page address */
          if(y < 8)  page = 0xB0;
     else if(y < 16) page = 0xB1;
@@ -838,3 +1110,488 @@ void oled_putString(uint8_t x, uint8_t y, uint8_t *pStr, oled_color_t fb,
   }
   return;
 }
+
+/******************************************************************************
+ *
+ * Description:
+ *    Write a line of text aligned to a page. The line is written in one
+ *    transfer and covers the whole display RAM width (132 columns, 22
+ *    characters), i.e. also the columns outside of the visible area. Text
+ *    that doesn't fit on the display can then be shown with
+ *    oled_scrollHorizontal without rewriting the line.
+ *
+ * Params:
+ *   [in] y - y position, must be a multiple of 8
+ *   [in] pStr - string to write
+ *   [in] fb - foreground color
+ *   [in] bg - background color
+ *
+ * Returns:
+ *   1 if the line was written, 0 if y isn't page aligned
+ *
+ *****************************************************************************/
+uint8_t oled_putStringLine(uint8_t y, uint8_t *pStr, oled_color_t fb,
+        oled_color_t bg)
+{
+    uint8_t buf[RAM_WIDTH];
+    uint8_t page = 0;
+    uint8_t ch = ' ';
+    int i = 0;
+    int col = 0;
+
+    if ((y >= OLED_DISPLAY_HEIGHT) || (((y + startLine) & 0x07) != 0))
+    {
+        return 0;
+    }
+
+    page = ((y + startLine) & (OLED_DISPLAY_HEIGHT-1)) >> 3;
+
+    /* text starts at the first visible column and wraps around */
+    for (i = 0; i < RAM_WIDTH; i++)
+    {
+        if ((i % 6) == 0)
+        {
+            ch = (*pStr != '\0') ? *pStr++ : ' ';
+        }
+
+        col = (i + X_OFFSET) % RAM_WIDTH;
+        buf[col] = charColumn(ch, i % 6, fb, bg);
+    }
+
+    memcpy(&shadowFB[page*OLED_DISPLAY_WIDTH], &buf[X_OFFSET],
+            OLED_DISPLAY_WIDTH);
+
+    setAddress(0xB0+page, 0x00, 0x10);
+    writeDataBuf(buf, RAM_WIDTH);
+
+    return 1;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Set the display start line. The content of the display moves up
+ *    by the difference to the previous start line and rows scrolled in
+ *    at the bottom are the ones that were scrolled out at the top. Only
+ *    the rows that should change need to be redrawn.
+ *
+ * Params:
+ *   [in] line - start line (0 - 63)
+ *
+ *****************************************************************************/
+void oled_setStartLine(uint8_t line)
+{
+    startLine = line & (OLED_DISPLAY_HEIGHT-1);
+    writeCommand(CMD_START_LINE | startLine);
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Get the display start line
+ *
+ * Returns:
+ *   Current start line (0 - 63)
+ *
+ *****************************************************************************/
+uint8_t oled_getStartLine(void)
+{
+    return startLine;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Start continuous horizontal scrolling of a range of rows. The
+ *    scrolling is done by the display controller and doesn't need any
+ *    transfers until it is stopped.
+ *
+ * Params:
+ *   [in] y0 - first row to scroll, rounded down to a page
+ *   [in] y1 - last row to scroll, rounded down to a page
+ *   [in] dir - scroll direction
+ *   [in] speed - number of frames between each scroll step
+ *
+ *****************************************************************************/
+void oled_scrollHorizontal(uint8_t y0, uint8_t y1, oled_scroll_dir_t dir,
+        oled_scroll_speed_t speed)
+{
+    uint8_t first = ((y0 + startLine) & (OLED_DISPLAY_HEIGHT-1)) >> 3;
+    uint8_t last  = ((y1 + startLine) & (OLED_DISPLAY_HEIGHT-1)) >> 3;
+
+    oled_scrollStop();
+
+    if (first > last)
+    {
+        /* range wraps around the end of display RAM */
+        first = 0;
+        last = NUM_PAGES-1;
+    }
+
+    writeCommand(dir == OLED_SCROLL_LEFT ? CMD_SCROLL_LEFT : CMD_SCROLL_RIGHT);
+    writeCommand(0x01);         // one column per step
+    writeCommand(first);
+    writeCommand(speed);
+    writeCommand(last);
+    writeCommand(CMD_SCROLL_START);
+
+    scrollFirst = first;
+    scrollLast = last;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Start continuous vertical scrolling. Rows above fixedRows stay in
+ *    place, the rest of the display moves offset rows per step.
+ *
+ * Params:
+ *   [in] fixedRows - number of rows at the top that don't scroll
+ *   [in] offset - number of rows to move per step (1 - 63)
+ *   [in] speed - number of frames between each scroll step
+ *
+ *****************************************************************************/
+void oled_scrollVertical(uint8_t fixedRows, uint8_t offset,
+        oled_scroll_speed_t speed)
+{
+    if (fixedRows >= OLED_DISPLAY_HEIGHT)
+    {
+        return;
+    }
+
+    oled_scrollStop();
+
+    writeCommand(CMD_SCROLL_AREA);
+    writeCommand(fixedRows);
+    writeCommand(OLED_DISPLAY_HEIGHT - fixedRows);
+
+    writeCommand(CMD_SCROLL_VERT_RIGHT);
+    writeCommand(0x00);         // no horizontal scrolling
+    writeCommand(0x00);
+    writeCommand(speed);
+    writeCommand(NUM_PAGES-1);
+    writeCommand(offset & (OLED_DISPLAY_HEIGHT-1));
+    writeCommand(CMD_SCROLL_START);
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Stop scrolling. The controller modifies the display RAM when
+ *    scrolling horizontally so the scrolled pages are restored from
+ *    the shadow framebuffer. Text outside of the visible area must
+ *    be written again before scrolling is restarted.
+ *
+ *****************************************************************************/
+void oled_scrollStop(void)
+{
+    uint8_t page = 0;
+
+    writeCommand(CMD_SCROLL_STOP);
+    writeCommand(CMD_START_LINE | startLine);
+
+    for (page = scrollFirst; page <= scrollLast; page++)
+    {
+        restorePage(page);
+    }
+
+    scrollFirst = 1;
+    scrollLast = 0;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Write columns of raw display data to a page. Only the given columns
+ *    are transferred which makes it suitable for partial updates, e.g.
+ *    bar graphs.
+ *
+ * Params:
+ *   [in] x - start x position
+ *   [in] y - y position, must be a multiple of 8
+ *   [in] data - one byte per column, bit 0 is the top row, 1 is white
+ *   [in] len - number of columns
+ *
+ *****************************************************************************/
+void oled_putColumns(uint8_t x, uint8_t y, uint8_t *data, uint8_t len)
+{
+    uint8_t page = 0;
+    uint16_t add = 0;
+
+    if ((x >= OLED_DISPLAY_WIDTH) || (y >= OLED_DISPLAY_HEIGHT)
+            || (((y + startLine) & 0x07) != 0))
+    {
+        return;
+    }
+
+    if (len > OLED_DISPLAY_WIDTH - x)
+    {
+        len = OLED_DISPLAY_WIDTH - x;
+    }
+
+    page = ((y + startLine) & (OLED_DISPLAY_HEIGHT-1)) >> 3;
+    add = x + X_OFFSET;
+
+    memcpy(&shadowFB[page*OLED_DISPLAY_WIDTH+x], data, len);
+
+    setAddress(0xB0+page, 0x0F & add, 0x10 | (add >> 4));
+    writeDataBuf(data, len);
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Write a character aligned to a page. The character is written in
+ *    one transfer of 6 columns, which is much cheaper than oled_putChar
+ *    when updating single characters, e.g. digits of a clock.
+ *
+ * Params:
+ *   [in] x - x position
+ *   [in] y - y position, must be a multiple of 8
+ *   [in] ch - character
+ *   [in] fb - foreground color
+ *   [in] bg - background color
+ *
+ * Returns:
+ *   1 if the character was written, 0 otherwise
+ *
+ *****************************************************************************/
+uint8_t oled_putCharLine(uint8_t x, uint8_t y, uint8_t ch, oled_color_t fb,
+        oled_color_t bg)
+{
+    uint8_t buf[6];
+    uint8_t i = 0;
+
+    if ((x > (OLED_DISPLAY_WIDTH - 6)) || (y >= OLED_DISPLAY_HEIGHT)
+            || (((y + startLine) & 0x07) != 0))
+    {
+        return 0;
+    }
+
+    for (i = 0; i < 6; i++)
+    {
+        buf[i] = charColumn(ch, i, fb, bg);
+    }
+
+    oled_putColumns(x, y, buf, 6);
+
+    return 1;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Get the SPI transfer statistics. Reset them with oled_resetStats at
+ *    the start of a frame to get the cost of drawing that frame.
+ *
+ * Params:
+ *   [out] pStats - number of transactions and bytes since the last reset
+ *
+ *****************************************************************************/
+void oled_getStats(oled_stats_t *pStats)
+{
+    *pStats = stats;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Reset the SPI transfer statistics
+ *
+ *****************************************************************************/
+void oled_resetStats(void)
+{
+    stats.transactions = 0;
+    stats.bytes = 0;
+}
+
+#ifdef OLED_USE_CAPTURE
+/******************************************************************************
+ *
+ * Description:
+ *    Get a pixel as it is shown on the display, reconstructed from the
+ *    captured commands and data
+ *
+ * Params:
+ *   [in] x - x position
+ *   [in] y - y position
+ *
+ * Returns:
+ *   Color of the pixel
+ *
+ *****************************************************************************/
+oled_color_t oled_captureGetPixel(uint8_t x, uint8_t y)
+{
+    uint8_t row = (y + captureStartLine) & (OLED_DISPLAY_HEIGHT-1);
+
+    if ((x >= OLED_DISPLAY_WIDTH) || (y >= OLED_DISPLAY_HEIGHT))
+    {
+        return OLED_COLOR_BLACK;
+    }
+
+    if ((captureRam[row >> 3][x + X_OFFSET] & (1 << (row & 0x07))) != 0)
+    {
+        return OLED_COLOR_WHITE;
+    }
+
+    return OLED_COLOR_BLACK;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Write a snapshot of the display to a PBM (portable bitmap) file
+ *
+ * Params:
+ *   [in] path - file name
+ *
+ * Returns:
+ *   0 on success, -1 if the file couldn't be written
+ *
+ *****************************************************************************/
+int oled_captureWritePbm(const char *path)
+{
+    FILE *f = NULL;
+    uint8_t x = 0;
+    uint8_t y = 0;
+
+    f = fopen(path, "w");
+    if (f == NULL)
+    {
+        return (-1);
+    }
+
+    fprintf(f, "P1\n%d %d\n", OLED_DISPLAY_WIDTH, OLED_DISPLAY_HEIGHT);
+    for (y = 0; y < OLED_DISPLAY_HEIGHT; y++)
+    {
+        for (x = 0; x < OLED_DISPLAY_WIDTH; x++)
+        {
+            /* in PBM 1 is black */
+            fputc(oled_captureGetPixel(x, y) == OLED_COLOR_WHITE ? '0' : '1', f);
+        }
+        fputc('\n', f);
+    }
+
+    return (fclose(f) == 0) ? 0 : (-1);
+}
+
+static uint32_t pngCrc(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+    uint32_t i = 0;
+    uint8_t k = 0;
+
+    for (i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (k = 0; k < 8; k++)
+        {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320UL) : (crc >> 1);
+        }
+    }
+    return crc;
+}
+
+static void pngPut32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static void pngChunk(FILE *f, const char *type, const uint8_t *data, uint32_t len)
+{
+    uint8_t buf[4];
+    uint32_t crc = 0;
+
+    pngPut32(buf, len);
+    fwrite(buf, 1, 4, f);
+    fwrite(type, 1, 4, f);
+    fwrite(data, 1, len, f);
+    crc = pngCrc(0xFFFFFFFFUL, (const uint8_t *)type, 4);
+    crc = pngCrc(crc, data, len);
+    pngPut32(buf, crc ^ 0xFFFFFFFFUL);
+    fwrite(buf, 1, 4, f);
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Write a snapshot of the display to a 1-bit grayscale PNG file. The
+ *    image data is stored uncompressed (deflate "stored" block) so that no
+ *    compression library is needed.
+ *
+ * Params:
+ *   [in] path - file name
+ *
+ * Returns:
+ *   0 on success, -1 if the file couldn't be written
+ *
+ *****************************************************************************/
+int oled_captureWritePng(const char *path)
+{
+#define PNG_STRIDE (1 + OLED_DISPLAY_WIDTH/8)
+#define PNG_RAW    (PNG_STRIDE * OLED_DISPLAY_HEIGHT)
+    static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t ihdr[13];
+    uint8_t idat[2 + 5 + PNG_RAW + 4];
+    uint8_t *raw = &idat[2 + 5];
+    uint32_t a = 1;
+    uint32_t b = 0;
+    uint32_t i = 0;
+    uint8_t x = 0;
+    uint8_t y = 0;
+    FILE *f = NULL;
+
+    memset(idat, 0, sizeof(idat));
+    for (y = 0; y < OLED_DISPLAY_HEIGHT; y++)
+    {
+        /* filter type 0, then 8 pixels per byte, MSB first, 1 is white */
+        for (x = 0; x < OLED_DISPLAY_WIDTH; x++)
+        {
+            if (oled_captureGetPixel(x, y) == OLED_COLOR_WHITE)
+            {
+                raw[y*PNG_STRIDE + 1 + (x >> 3)] |= (uint8_t)(0x80 >> (x & 7));
+            }
+        }
+    }
+
+    /* zlib header, one final stored block, Adler-32 of the raw data */
+    idat[0] = 0x78;
+    idat[1] = 0x01;
+    idat[2] = 0x01;
+    idat[3] = (uint8_t)(PNG_RAW & 0xFF);
+    idat[4] = (uint8_t)(PNG_RAW >> 8);
+    idat[5] = (uint8_t)(~PNG_RAW & 0xFF);
+    idat[6] = (uint8_t)((~PNG_RAW >> 8) & 0xFF);
+    for (i = 0; i < PNG_RAW; i++)
+    {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    pngPut32(&raw[PNG_RAW], (b << 16) | a);
+
+    pngPut32(&ihdr[0], OLED_DISPLAY_WIDTH);
+    pngPut32(&ihdr[4], OLED_DISPLAY_HEIGHT);
+    ihdr[8] = 1;    /* bit depth */
+    ihdr[9] = 0;    /* grayscale */
+    ihdr[10] = 0;
+    ihdr[11] = 0;
+    ihdr[12] = 0;
+
+    f = fopen(path, "wb");
+    if (f == NULL)
+    {
+        return (-1);
+    }
+
+    fwrite(sig, 1, sizeof(sig), f);
+    pngChunk(f, "IHDR", ihdr, sizeof(ihdr));
+    pngChunk(f, "IDAT", idat, sizeof(idat));
+    pngChunk(f, "IEND", NULL, 0);
+
+    return (fclose(f) == 0) ? 0 : (-1);
+#undef PNG_STRIDE
+#undef PNG_RAW
+}
+#endif
@@ -7,8 +7,8 @@
  ******************************************************************************/
 
 /*
- * NOTE: I2C must have been initialized before calling any functions in this
- * file.
+ * NOTE: I2C must have been initialized (i2cq_init) before calling any
+ * functions in this file.
  */
 
 /******************************************************************************
@@ -16,18 +16,21 @@
  *****************************************************************************/
 
 #include "lpc17xx_i2c.h"
+#include "i2cq.h"
 #include "pca9532.h"
 
 /******************************************************************************
  * Defines and typedefs
  *****************************************************************************/
 
-#define I2CDEV LPC_I2C2
-
 #define LS_MODE_ON     0x01
 #define LS_MODE_BLINK0 0x02
 #define LS_MODE_BLINK1 0x03
 
+/* shadowed registers PSC0 - LS3 */
+#define REG_FIRST  PCA9532_PSC0
+#define REG_COUNT  (PCA9532_LS3 - PCA9532_PSC0 + 1)
+
 /******************************************************************************
  * External global variables
  *****************************************************************************/
@@ -41,44 +44,28 @@ static uint16_t blink0Shadow = 0;
 static uint16_t blink1Shadow = 0;
 static uint16_t ledStateShadow = 0;
 
+/* register values wanted and last sent to the device */
+static uint8_t regWanted[REG_COUNT];
+static uint8_t regSent[REG_COUNT];
+static uint8_t regSentValid = 0;
+static uint8_t deferred = 0;
+
+static pca9532_stats_t stats;
+
 /******************************************************************************
  * Local Functions
  *****************************************************************************/
 
 static int I2CRead(uint8_t addr, uint8_t* buf, uint32_t len)
 {
-	I2C_M_SETUP_Type rxsetup;
-
-	rxsetup.sl_addr7bit = addr;
-	rxsetup.tx_data = NULL;	// Get address to read at writing address
-	rxsetup.tx_length = 0;
-	rxsetup.rx_data = buf;
-	rxsetup.rx_length = len;
-	rxsetup.retransmissions_max = 3;
-
-	if (I2C_MasterTransferData(I2CDEV, &rxsetup, I2C_TRANSFER_POLLING) == SUCCESS){
-		return (0);
-	} else {
-		return (-1);
-	}
+	/* waits for earlier queued writes and this read */
+	return i2cq_transfer(addr, NULL, 0, buf, len);
 }
 
 static int I2CWrite(uint8_t addr, uint8_t* buf, uint32_t len)
 {
-	I2C_M_SETUP_Type txsetup;
-
-	txsetup.sl_addr7bit = addr;
-	txsetup.tx_data = buf;
-	txsetup.tx_length = len;
-	txsetup.rx_data = NULL;
-	txsetup.rx_length = 0;
-	txsetup.retransmissions_max = 3;
-
-	if (I2C_MasterTransferData(I2CDEV, &txsetup, I2C_TRANSFER_POLLING) == SUCCESS){
-		return (0);
-	} else {
-		return (-1);
-	}
+	/* queued, the data is copied and sent from the I2C interrupt */
+	return i2cq_write(addr, buf, len);
 }
 
 static void setLsStates(uint16_t states, uint8_t* ls, uint8_t mode)
@@ -98,11 +85,56 @@ static void setLsStates(uint16_t states, uint8_t* ls, uint8_t mode)
     }
 }
 
+/*
+ * Send the registers that differ from what the device already has, as one
+ * auto-increment write covering the first to the last changed register.
+ */
+static void flushRegs(void)
+{
+    uint8_t buf[REG_COUNT + 1];
+    int first = -1;
+    int last = -1;
+    int i = 0;
+
+    for (i = 0; i < REG_COUNT; i++) {
+        if (((regSentValid & (1 << i)) == 0) || (regWanted[i] != regSent[i])) {
+            if (first < 0) {
+                first = i;
+            }
+            last = i;
+        }
+    }
+
+    if (first < 0) {
+        stats.skipped++;
+        return;
+    }
+
+    buf[0] = (REG_FIRST + first) | PCA9532_AUTO_INC;
+    for (i = first; i <= last; i++) {
+        buf[1 + i - first] = regWanted[i];
+        regSent[i] = regWanted[i];
+        regSentValid |= (1 << i);
+    }
+    I2CWrite(PCA9532_I2C_ADDR, buf, last - first + 2);
+
+    stats.writes++;
+    stats.bytes += last - first + 2;
+}
+
+static void setReg(uint8_t reg, uint8_t value)
+{
+    regWanted[reg - REG_FIRST] = value;
+    if (!deferred) {
+        flushRegs();
+    }
+}
+
 static void setLeds(void)
 {
-    uint8_t buf[5];
     uint8_t ls[4] = {0,0,0,0};
     uint16_t states = ledStateShadow;
+    int i = 0;
 
     /* LEDs in On/Off state */
     setLsStates(states, ls, LS_MODE_ON);
@@ -111,12 +143,12 @@ static void setLeds(void)
     setLsStates(blink0Shadow, ls, LS_MODE_BLINK0);
     setLsStates(blink1Shadow, ls, LS_MODE_BLINK1);
 
-    buf[0] = PCA9532_LS0 | PCA9532_AUTO_INC;
-    buf[1] = ls[0];
-    buf[2] = ls[1];
-    buf[3] = ls[2];
-    buf[4] = ls[3];
-    I2CWrite(PCA9532_I2C_ADDR, buf, 5);
+    for (i = 0; i < 4; i++) {
+        regWanted[PCA9532_LS0 - REG_FIRST + i] = ls[i];
+    }
+    if (!deferred) {
+        flushRegs();
+    }
 }
 
 /******************************************************************************
@@ -192,7 +224,8 @@ uint16_t pca9532_getLedState (uint32_t shadow)
 /******************************************************************************
  *
  * Description:
- *    Set LED states (on or off).
+ *    Set LED states (on or off). Blinking is turned off for all LEDs in
+ *    both masks.
  *
  * Params:
  *    [in]  ledOnMask  - The LEDs that should be turned on. This mask has
@@ -208,9 +241,12 @@ void pca9532_setLeds (uint16_t ledOnMask, uint16_t ledOffMask)
     /* ledOnMask has priority over ledOffMask */
     ledStateShadow |= ledOnMask;
 
-    /* turn off blinking */
-    blink0Shadow &= (~(ledOffMask) & 0xffff);
-    blink1Shadow &= (~(ledOffMask) & 0xffff);
+    /*
+     * turn off blinking, also for LEDs turned on: the LS bits are OR:ed
+     * and ON | BLINK0 would give BLINK1
+     */
+    blink0Shadow &= (~(ledOffMask | ledOnMask) & 0xffff);
+    blink1Shadow &= (~(ledOffMask | ledOnMask) & 0xffff);
 
     setLeds();
 }
@@ -227,11 +263,7 @@ void pca9532_setLeds (uint16_t ledOnMask, uint16_t ledOffMask)
  *****************************************************************************/
 void pca9532_setBlink0Period(uint8_t period)
 {
-    uint8_t buf[2];
-
-    buf[0] = PCA9532_PSC0;
-    buf[1] = period;
-    I2CWrite(PCA9532_I2C_ADDR, buf, 2);
+    setReg(PCA9532_PSC0, period);
 }
 
 /******************************************************************************
@@ -246,17 +278,29 @@ void pca9532_setBlink0Period(uint8_t period)
  *****************************************************************************/
 void pca9532_setBlink0Duty(uint8_t duty)
 {
-    uint8_t buf[2];
     uint32_t tmp = duty;
     if (tmp > 100) {
         tmp = 100;
     }
 
-    tmp = (256 * tmp)/100;
+    tmp = (255 * tmp)/100;
 
-    buf[0] = PCA9532_PWM0;
-    buf[1] = tmp;
-    I2CWrite(PCA9532_I2C_ADDR, buf, 2);
+    setReg(PCA9532_PWM0, tmp);
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Set the raw PWM0 register. With period 0 (152 Hz) the blinking is not
+ *    visible and the LEDs in blink0 mode are dimmed to pwm/256.
+ *
+ * Params:
+ *    [in]  pwm  - on time in 1/256 of the period
+ *
+ *****************************************************************************/
+void pca9532_setBlink0Pwm(uint8_t pwm)
+{
+    setReg(PCA9532_PWM0, pwm);
 }
 
 /******************************************************************************
@@ -287,11 +331,7 @@ void pca9532_setBlink0Leds(uint16_t ledMask)
  *****************************************************************************/
 void pca9532_setBlink1Period(uint8_t period)
 {
-    uint8_t buf[2];
-
-    buf[0] = PCA9532_PSC1;
-    buf[1] = period;
-    I2CWrite(PCA9532_I2C_ADDR, buf, 2);
+    setReg(PCA9532_PSC1, period);
 }
 
 /******************************************************************************
@@ -306,18 +346,14 @@ void pca9532_setBlink1Period(uint8_t period)
  *****************************************************************************/
 void pca9532_setBlink1Duty(uint8_t duty)
 {
-    uint8_t buf[2];
-
     uint32_t tmp = duty;
     if (tmp > 100) {
         tmp = 100;
     }
 
-    tmp = (256 * tmp)/100;
+    tmp = (255 * tmp)/100;
 
-    buf[0] = PCA9532_PWM1;
-    buf[1] = tmp;
-    I2CWrite(PCA9532_I2C_ADDR, buf, 2);
+    setReg(PCA9532_PWM1, tmp);
 }
 
 /******************************************************************************
@@ -335,3 +371,47 @@ void pca9532_setBlink1Leds(uint16_t ledMask)
     blink1Shadow |= ledMask;
     setLeds();
 }
+
+/******************************************************************************
+ *
+ * Description:
+ *    Defer register writes. While deferred, the set functions only update
+ *    the shadow registers and pca9532_flush sends everything that changed
+ *    in one transaction, so a burst of updates costs a single write.
+ *
+ * Params:
+ *    [in]  on  - 1 to defer writes until pca9532_flush, 0 to write at once
+ *
+ *****************************************************************************/
+void pca9532_setDeferred(uint8_t on)
+{
+    deferred = on;
+    if (!deferred) {
+        flushRegs();
+    }
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Send the changed registers. Does nothing if the device is up to date.
+ *
+ *****************************************************************************/
+void pca9532_flush(void)
+{
+    flushRegs();
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Get the write statistics
+ *
+ * Params:
+ *    [out] pStats - writes, bytes and skipped (unchanged) flushes
+ *
+ *****************************************************************************/
+void pca9532_getStats(pca9532_stats_t *pStats)
+{
+    *pStats = stats;
+}
@@ -27,6 +27,8 @@ typedef enum {
 /* Prototypes for disk control functions */
 
 DSTATUS disk_initialize (BYTE);
+DSTATUS disk_init_start (BYTE);
+BYTE disk_init_poll (BYTE);
 DSTATUS disk_status (BYTE);
 DRESULT disk_read (BYTE, BYTE*, DWORD, BYTE);
 #if	_READONLY == 0
@@ -86,7 +86,7 @@
 */
 
 
-#define	_USE_LFN	0		/* 0, 1 or 2 */
+#define	_USE_LFN	1		/* 0, 1 or 2 */
 #define	_MAX_LFN	64		/* Maximum LFN length to handle (12 to 255) */
 /* The _USE_LFN option switches the LFN support.
 /
@@ -111,6 +111,20 @@
 /  Note that output of the f_readdir fnction is affected by this option. */
 
 
+#define _USE_DIRHASH	1		/* 0 or 1 */
+#define _DIRHASH_SIZE	256		/* Number of hash slots (power of 2, 2 bytes each) */
+/* When _USE_DIRHASH is set to 1, a full f_readdir walk of a directory from its
+/  first entry builds a table of SFN hash -> entry index for that directory.
+/  dir_find() then seeks straight to the entry instead of scanning the table
+/  from the top. The table is filled up to 3/4 of the slots, entries beyond
+/  that are found by the linear scan. Only one directory is hashed at a time,
+/  and creating or removing an entry in it drops the table. A name that is not
+/  found by the hash falls back to the linear scan, so the result never differs
+/  from _USE_DIRHASH 0.
+/  f_unlink and f_rename must be removed (_FS_MINIMIZE >= 1 or _FS_READONLY),
+/  because a hashed hit does not locate the LFN entries of the object. */
+
+
 
 /*---------------------------------------------------------------------------/
 / Physical Drive Configurations
@@ -0,0 +1,90 @@
+/*------------------------------------------------------------------------*/
+/* Unicode - OEM code bidirectional converter  (C)ChaN, 2009              */
+/*                                                                        */
+/* CP858 (Multilingual Latin 1 + Euro) only                               */
+/*------------------------------------------------------------------------*/
+/* The other SBCS tables of the original module are left out; only the   */
+/* code page selected by _CODE_PAGE in ffconf.h is needed by this board. */
+/* Upper case conversion covers ASCII, Latin-1 and the Latin Extended-A  */
+/* pairs, which is what can be reached through CP858.                    */
+/*------------------------------------------------------------------------*/
+
+#include "ff.h"
+
+#if _USE_LFN
+
+#if _CODE_PAGE != 858
+#error This file supports only CP858. Set _CODE_PAGE to 858 or add the table.
+#endif
+
+static
+const WCHAR Tbl[] = {	/*  CP858(0x80-0xFF) to Unicode conversion table */
+	0x00C7, 0x00FC, 0x00E9, 0x00E2, 0x00E4, 0x00E0, 0x00E5, 0x00E7,
+	0x00EA, 0x00EB, 0x00E8, 0x00EF, 0x00EE, 0x00EC, 0x00C4, 0x00C5,
+	0x00C9, 0x00E6, 0x00C6, 0x00F4, 0x00F6, 0x00F2, 0x00FB, 0x00F9,
+	0x00FF, 0x00D6, 0x00DC, 0x00F8, 0x00A3, 0x00D8, 0x00D7, 0x0192,
+	0x00E1, 0x00ED, 0x00F3, 0x00FA, 0x00F1, 0x00D1, 0x00AA, 0x00BA,
+	0x00BF, 0x00AE, 0x00AC, 0x00BD, 0x00BC, 0x00A1, 0x00AB, 0x00BB,
+	0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x00C1, 0x00C2, 0x00C0,
+	0x00A9, 0x2563, 0x2551, 0x2557, 0x255D, 0x00A2, 0x00A5, 0x2510,
+	0x2514, 0x2534, 0x252C, 0x251C, 0x2500, 0x253C, 0x00E3, 0x00C3,
+	0x255A, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256C, 0x00A4,
+	0x00F0, 0x00D0, 0x00CA, 0x00CB, 0x00C8, 0x20AC, 0x00CD, 0x00CE,
+	0x00CF, 0x2518, 0x250C, 0x2588, 0x2584, 0x00A6, 0x00CC, 0x2580,
+	0x00D3, 0x00DF, 0x00D4, 0x00D2, 0x00F5, 0x00D5, 0x00B5, 0x00FE,
+	0x00DE, 0x00DA, 0x00DB, 0x00D9, 0x00FD, 0x00DD, 0x00AF, 0x00B4,
+	0x00AD, 0x00B1, 0x2017, 0x00BE, 0x00B6, 0x00A7, 0x00F7, 0x00B8,
+	0x00B0, 0x00A8, 0x00B7, 0x00B9, 0x00B3, 0x00B2, 0x25A0, 0x00A0
+};
+
+
+
+WCHAR ff_convert (	/* Converted character, Returns zero on error */
+	WCHAR	src,	/* Character code to be converted */
+	UINT	dir		/* 0: Unicode to OEMCP, 1: OEMCP to Unicode */
+)
+{
+	WCHAR c;
+
+
+	if (src < 0x80) {	/* ASCII */
+		c = src;
+
+	} else {
+		if (dir) {		/* OEMCP to Unicode */
+			c = (src >= 0x100) ? 0 : Tbl[src - 0x80];
+
+		} else {		/* Unicode to OEMCP */
+			for (c = 0; c < 0x80; c++) {
+				if (src == Tbl[c]) break;
+			}
+			c = (c + 0x80) & 0xFF;
+		}
+	}
+
+	return c;
+}
+
+
+
+WCHAR ff_wtoupper (	/* Upper converted character */
+	WCHAR chr		/* Input character */
+)
+{
+	if (chr >= 'a' && chr <= 'z')					/* ASCII */
+		return chr - 0x20;
+	if (chr >= 0xE0 && chr <= 0xFE && chr != 0xF7)	/* Latin-1 */
+		return chr - 0x20;
+	if (chr == 0xFF)
+		return 0x178;
+	if (chr >= 0x100 && chr <= 0x17F				/* Latin Extended-A pairs */
+		&& chr != 0x130 && chr != 0x131 && chr != 0x138 && chr != 0x149 && chr != 0x17F) {
+		if ((chr >= 0x139 && chr <= 0x148) || (chr >= 0x179 && chr <= 0x17E))
+			return (chr & 1) ? chr : chr - 1;		/* Odd upper case in these ranges */
+		return (chr & 1) ? chr - 1 : chr;
+	}
+
+	return chr;
+}
+
+#endif /* _USE_LFN */
@@ -141,6 +141,33 @@ BYTE Drive;				/* Current drive */
 #endif
 
 
+#if _USE_DIRHASH
+#if _FS_REENTRANT
+#error Directory hash table must not be used in re-entrant configuration.
+#endif
+#if !_FS_READONLY && !_FS_MINIMIZE
+#error Directory hash table requires f_unlink and f_rename to be removed.
+#endif
+#if _DIRHASH_SIZE & (_DIRHASH_SIZE - 1)
+#error _DIRHASH_SIZE must be a power of 2.
+#endif
+static
+FATFS *DhFs;			/* File system of the hashed directory */
+static
+WORD DhId;				/* Mount ID of the hashed directory */
+static
+DWORD DhClust;			/* Start cluster of the hashed directory */
+static
+DIR *DhDir;				/* Directory object walking the directory while the table is built */
+static
+BYTE DhState;			/* 0:No table, 1:Being built, 2:Complete */
+static
+WORD DhCount;			/* Number of entries in the table */
+static
+WORD DhTbl[_DIRHASH_SIZE];	/* 4-bit tag and SFN index + 1, 0:Blank slot */
+#endif
+
+
 #if _USE_LFN == 1	/* LFN with static LFN working buffer */
 static
 WCHAR LfnBuf[_MAX_LFN + 1];
@@ -822,6 +849,132 @@ BYTE sum_sfn (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Directory hash table - Build, look up and drop                        */
+/*-----------------------------------------------------------------------*/
+#if _USE_DIRHASH
+#define DH_TAG(h)	((h) & 0xF000)
+#define DH_IDX		0x0FFF
+
+static
+WORD dh_hash (			/* Hash value of an SFN */
+	const BYTE *fn		/* Pointer to the 11-byte SFN in directory form */
+)
+{
+	WORD h = 0;
+	int n = 11;
+
+
+	do h = (WORD)(h * 31 + *fn++); while (--n);
+	return h ^ (h >> 7);
+}
+
+
+
+static
+void dh_start (
+	DIR *dj				/* Directory object rewound to the first entry */
+)
+{
+	mem_set(DhTbl, 0, sizeof(DhTbl));
+	DhFs = dj->fs; DhId = dj->fs->id; DhClust = dj->sclust;
+	DhDir = dj;
+	DhCount = 0;
+	DhState = 1;
+}
+
+
+
+static
+void dh_add (
+	DIR *dj				/* Directory object pointing the SFN entry just read */
+)
+{
+	WORD h, i, n;
+
+
+	if (DhState != 1 || DhDir != dj || DhClust != dj->sclust) return;
+	if (dj->index >= DH_IDX) return;	/* Beyond the index range, left to the linear scan */
+	if (DhCount >= _DIRHASH_SIZE / 4 * 3) return;	/* Load limit, rest is left to the linear scan */
+
+	h = dh_hash(dj->dir);
+	i = h & (_DIRHASH_SIZE - 1);
+	for (n = 0; n < _DIRHASH_SIZE; n++) {	/* Linear probing */
+		if (!DhTbl[i]) {
+			DhTbl[i] = DH_TAG(h) | (WORD)(dj->index + 1);
+			DhCount++;
+			return;
+		}
+		i = (i + 1) & (_DIRHASH_SIZE - 1);
+	}
+}
+
+
+
+static
+void dh_end (
+	DIR *dj				/* Directory object that reached the end of the table */
+)
+{
+	if (DhState == 1 && DhDir == dj && DhClust == dj->sclust) DhState = 2;
+}
+
+
+
+#if !_FS_READONLY
+static
+void dh_drop (
+	DIR *dj				/* Directory to be modified */
+)
+{
+	if (DhFs == dj->fs && DhClust == dj->sclust) DhState = 0;
+}
+#endif
+
+
+
+static
+FRESULT dh_find (		/* FR_OK:Found, FR_NO_FILE:Not in the table, others:Disk error */
+	DIR *dj				/* Pointer to the directory object linked to the file name */
+)
+{
+	FRESULT res;
+	WORD h, i, n, e;
+	BYTE *dir;
+
+
+	if (DhState != 2 || DhFs != dj->fs || DhId != dj->fs->id || DhClust != dj->sclust)
+		return FR_NO_FILE;
+	if (dj->fn[0] == '.') return FR_NO_FILE;	/* Dot entries are not hashed */
+#if _USE_LFN
+	if (dj->fn[NS] & (NS_LOSS | NS_LFN)) return FR_NO_FILE;	/* Only an 8.3 name can be looked up */
+#endif
+
+	h = dh_hash(dj->fn);
+	i = h & (_DIRHASH_SIZE - 1);
+	for (n = 0; n < _DIRHASH_SIZE && (e = DhTbl[i]) != 0; n++) {
+		if (DH_TAG(e) == DH_TAG(h)) {	/* Candidate, check the entry itself */
+			res = dir_seek(dj, (WORD)((e & DH_IDX) - 1));
+			if (res == FR_OK) res = move_window(dj->fs, dj->sect);
+			if (res != FR_OK) return res;
+			dir = dj->dir;
+			if (dir[DIR_Name] != 0xE5 && !(dir[DIR_Attr] & AM_VOL) && !mem_cmp(dir, dj->fn, 11)) {
+#if _USE_LFN
+				dj->lfn_idx = 0xFFFF;
+#endif
+				return FR_OK;
+			}
+		}
+		i = (i + 1) & (_DIRHASH_SIZE - 1);
+	}
+
+	return FR_NO_FILE;
+}
+#endif
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Find an object in the directory                  */
 /*-----------------------------------------------------------------------*/
@@ -837,6 +990,11 @@ FRESULT dir_find (
 	BYTE a, ord, sum;
 #endif
 
+#if _USE_DIRHASH
+	res = dh_find(dj);				/* Try the hash table of the directory */
+	if (res != FR_NO_FILE) return res;
+#endif
+
 	res = dir_seek(dj, 0);			/* Rewind directory object */
 	if (res != FR_OK) return res;
 
@@ -957,6 +1115,9 @@ FRESULT dir_register (	/* FR_OK:Successful, FR_DENIED:No free entry or too many
 	WCHAR *lfn;
 
 
+#if _USE_DIRHASH
+	dh_drop(dj);
+#endif
 	fn = dj->fn; lfn = dj->lfn;
 	mem_cpy(sn, fn, 12);
 
@@ -1014,6 +1175,9 @@ FRESULT dir_register (	/* FR_OK:Successful, FR_DENIED:No free entry or too many
 	}
 
 #else	/* Non LFN configuration */
+#if _USE_DIRHASH
+	dh_drop(dj);
+#endif
 	res = dir_seek(dj, 0);
 	if (res == FR_OK) {
 		do {	/* Find a blank entry for the SFN */
@@ -2254,12 +2418,21 @@ FRESULT f_readdir (
 		if (!fno) {
 			res = dir_seek(dj, 0);
 		} else {
+#if _USE_DIRHASH
+			if (dj->index == 0 && dj->sect) dh_start(dj);	/* Walk from the top, hash it */
+#endif
 			res = dir_read(dj);
 			if (res == FR_NO_FILE) {
+#if _USE_DIRHASH
+				dh_end(dj);
+#endif
 				dj->sect = 0;
 				res = FR_OK;
 			}
 			if (res == FR_OK) {				/* A valid entry is found */
+#if _USE_DIRHASH
+				if (dj->sect) dh_add(dj);
+#endif
 				get_fileinfo(dj, fno);		/* Get the object information */
 				res = dir_next(dj, FALSE);	/* Increment index for next */
 				if (res == FR_NO_FILE) {
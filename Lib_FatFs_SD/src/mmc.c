@@ -52,11 +52,17 @@ static volatile
 DSTATUS Stat = STA_NOINIT;	/* Disk status */
 
 static volatile
-BYTE Timer1, Timer2;	/* 100Hz decrement timer */
+WORD Timer1, Timer2;	/* 1kHz decrement timer */
 
 static
 BYTE CardType;			/* Card type flags */
 
+static
+BYTE InitState;			/* Stepped initialization: 0:idle, 1:ACMD41 (SDv2), 2:InitCmd (SDv1/MMC) */
+
+static
+BYTE InitType, InitCmd;	/* Card type and idle state poll command while initializing */
+
 static void SSPSend(uint8_t *buf, uint32_t Length)
 {
     SSP_DATA_SETUP_Type xferConfig;
@@ -125,7 +131,7 @@ BYTE wait_ready (void)
 	BYTE res;
 
 
-	Timer2 = 50;	/* Wait for ready in timeout of 500ms */
+	Timer2 = 500;	/* Wait for ready in timeout of 500ms */
 	rcvr_spi();
 	do
 		res = rcvr_spi();
@@ -203,7 +209,7 @@ BOOL rcvr_datablock (
 	BYTE token;
 
 
-	Timer1 = 20;
+	Timer1 = 200;
 	do {							/* Wait for data packet in timeout of 200ms */
 		token = rcvr_spi();
 	} while ((token == 0xFF) && Timer1);
@@ -313,18 +319,21 @@ BYTE send_cmd (
 
 
 /*-----------------------------------------------------------------------*/
-/* Initialize Disk Drive                                                 */
+/* Start Disk Drive initialization (non-blocking)                        */
 /*-----------------------------------------------------------------------*/
+/* Sends the reset and interface condition commands and returns. The     */
+/* card leaves the idle state through disk_init_poll() calls.            */
 
-DSTATUS disk_initialize (
+DSTATUS disk_init_start (
 	BYTE drv		/* Physical drive nmuber (0) */
 )
 {
-	BYTE n, cmd, ty, ocr[4];
+	BYTE n, ocr[4];
 
 	GPIO_SetDir(2, 1<<2, 1);  /* CS */
 	GPIO_SetDir(2, 1<<11, 0); /* Card Detect */
 
+	InitState = 0;
 	if (drv) return STA_NOINIT;			/* Supports only single drive */
 	if (Stat & STA_NODISK) return Stat;	/* No card in the socket */
 
@@ -332,29 +341,68 @@ DSTATUS disk_initialize (
 	FCLK_SLOW();
 	for (n = 10; n; n--) rcvr_spi();	/* 80 dummy clocks */
 
-	ty = 0;
+	InitType = 0;
 	if (send_cmd(CMD0, 0) == 1) {			/* Enter Idle state */
-		Timer1 = 100;						/* Initialization timeout of 1000 msec */
+		Timer1 = 1000;						/* Initialization timeout of 1000 msec */
 		if (send_cmd(CMD8, 0x1AA) == 1) {	/* SDHC */
 			for (n = 0; n < 4; n++) ocr[n] = rcvr_spi();		/* Get trailing return value of R7 resp */
 			if (ocr[2] == 0x01 && ocr[3] == 0xAA) {				/* The card can work at vdd range of 2.7-3.6V */
-				while (Timer1 && send_cmd(ACMD41, 1UL << 30));	/* Wait for leaving idle state (ACMD41 with HCS bit) */
-				if (Timer1 && send_cmd(CMD58, 0) == 0) {		/* Check CCS bit in the OCR */
-					for (n = 0; n < 4; n++) ocr[n] = rcvr_spi();
-					ty = (ocr[0] & 0x40) ? CT_SD2 | CT_BLOCK : CT_SD2;	/* SDv2 */
-				}
+				InitState = 1;
 			}
 		} else {							/* SDSC or MMC */
 			if (send_cmd(ACMD41, 0) <= 1) 	{
-				ty = CT_SD1; cmd = ACMD41;	/* SDv1 */
+				InitType = CT_SD1; InitCmd = ACMD41;	/* SDv1 */
 			} else {
-				ty = CT_MMC; cmd = CMD1;	/* MMCv3 */
+				InitType = CT_MMC; InitCmd = CMD1;	/* MMCv3 */
 			}
-			while (Timer1 && send_cmd(cmd, 0));			/* Wait for leaving idle state */
-			if (!Timer1 || send_cmd(CMD16, 512) != 0)	/* Set R/W block length to 512 */
-				ty = 0;
+			InitState = 2;
 		}
 	}
+	deselect();
+
+	if (!InitState) power_off();		/* Initialization failed */
+
+	return Stat;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Continue Disk Drive initialization (non-blocking)                     */
+/*-----------------------------------------------------------------------*/
+/* Sends one idle state poll per call and releases the bus in between.   */
+/* Returns 0 while the card is still initializing and 1 when finished;   */
+/* disk_status() then tells the result.                                  */
+
+BYTE disk_init_poll (
+	BYTE drv		/* Physical drive nmuber (0) */
+)
+{
+	BYTE n, ty, ocr[4];
+
+
+	if (drv || !InitState) return 1;
+
+	ty = 0;
+	if (InitState == 1) {
+		if (Timer1 && send_cmd(ACMD41, 1UL << 30)) {	/* Still in idle state (ACMD41 with HCS bit) */
+			deselect();
+			return 0;
+		}
+		if (Timer1 && send_cmd(CMD58, 0) == 0) {		/* Check CCS bit in the OCR */
+			for (n = 0; n < 4; n++) ocr[n] = rcvr_spi();
+			ty = (ocr[0] & 0x40) ? CT_SD2 | CT_BLOCK : CT_SD2;	/* SDv2 */
+		}
+	} else {
+		if (Timer1 && send_cmd(InitCmd, 0)) {			/* Still in idle state */
+			deselect();
+			return 0;
+		}
+		ty = InitType;
+		if (!Timer1 || send_cmd(CMD16, 512) != 0)	/* Set R/W block length to 512 */
+			ty = 0;
+	}
+	InitState = 0;
 	CardType = ty;
 	deselect();
 
@@ -365,7 +413,23 @@ DSTATUS disk_initialize (
 		power_off();
 	}
 
-	return Stat;
+	return 1;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Initialize Disk Drive                                                 */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_initialize (
+	BYTE drv		/* Physical drive nmuber (0) */
+)
+{
+	disk_init_start(drv);
+	while (!disk_init_poll(drv)) ;
+
+	return disk_status(drv);
 }
 
 
@@ -601,18 +665,19 @@ DRESULT disk_ioctl (
 /*-----------------------------------------------------------------------*/
 /* Device Timer Interrupt Procedure  (Platform dependent)                */
 /*-----------------------------------------------------------------------*/
-/* This function must be called in period of 10ms                        */
+/* This function must be called in period of 1ms                         */
 
 void disk_timerproc (void)
 {
 	static BYTE pv;
 	BYTE n, s;
+	WORD t;
 
 
-	n = Timer1;						/* 100Hz decrement timer */
-	if (n) Timer1 = --n;
-	n = Timer2;
-	if (n) Timer2 = --n;
+	t = Timer1;						/* 1kHz decrement timer */
+	if (t) Timer1 = --t;
+	t = Timer2;
+	if (t) Timer2 = --t;
 
 	n = pv;
 	//pv = SOCKPORT & (SOCKWP | SOCKINS);	/* Sample socket switch */
@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "host.h"
+#include "fft.h"
+
+#define LOOPS 20000U
+
+/*!
+ *  @brief    Mierzy czas okna i FFT dla każdego obsługiwanego rozmiaru.
+ *
+ *  Wynik na komputerze służy do porównań między wersjami kodu, nie do
+ *  szacowania czasu na LPC1769.
+ */
+int main(void)
+{
+    static int16_t src[1U << FFT_MAX_LOG2N];
+    static int16_t re[1U << FFT_MAX_LOG2N];
+    static int16_t im[1U << FFT_MAX_LOG2N];
+    uint32_t i;
+    uint32_t n;
+    uint8_t log2n;
+    uint64_t t0;
+    uint64_t c0;
+    uint64_t ns;
+    uint64_t cycles;
+    uint32_t sink = 0U;
+
+    for (i = 0U; i < (1U << FFT_MAX_LOG2N); i++) {
+        src[i] = (int16_t)((i * 2654435761UL) >> 16);
+    }
+
+    for (log2n = FFT_MIN_LOG2N; log2n <= FFT_MAX_LOG2N; log2n++) {
+        n = 1U << log2n;
+        t0 = host_ns();
+        c0 = host_cycles();
+        for (i = 0U; i < LOOPS; i++) {
+            (void)memcpy(re, src, n * sizeof(re[0]));
+            (void)memset(im, 0, n * sizeof(im[0]));
+            fft_window(re, log2n);
+            fft_q15(re, im, log2n);
+            sink += fft_mag(re[1], im[1]);
+        }
+        cycles = host_cycles() - c0;
+        ns = host_ns() - t0;
+        (void)printf("fft %3u pkt: %6.0f ns, %7.0f cykli na okno+FFT\n",
+            (unsigned)n, (double)ns / LOOPS, (double)cycles / LOOPS);
+    }
+    return (sink == 0xFFFFFFFFU) ? 1 : 0;
+}
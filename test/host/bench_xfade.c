@@ -0,0 +1,52 @@
+#include <stdio.h>
+
+#include "host.h"
+#include "xfade.h"
+
+#define CHUNK 256U
+#define RUNS 20U
+
+/*!
+ *  @brief    Mierzy koszt miksowania całego przejścia XFADE_MAX_S sekund
+ *            w blokach połówki bufora.
+ *
+ *  Wynik na komputerze służy do porównań między wersjami kodu, nie do
+ *  szacowania czasu na LPC1769.
+ */
+int main(void)
+{
+    static uint8_t out[CHUNK];
+    static uint8_t in[CHUNK];
+    uint32_t total = XFADE_MAX_S * 16000U;
+    uint32_t pos;
+    uint32_t r;
+    uint32_t i;
+    uint32_t blocks = 0U;
+    uint64_t t0;
+    uint64_t c0;
+    uint64_t ns;
+    uint64_t cycles;
+
+    for (i = 0U; i < CHUNK; i++) {
+        in[i] = (uint8_t)(i * 37U);
+    }
+
+    xfade_init(host_us);
+    t0 = host_ns();
+    c0 = host_cycles();
+    for (r = 0U; r < RUNS; r++) {
+        for (pos = 0U; pos < total; pos += CHUNK) {
+            for (i = 0U; i < CHUNK; i++) {
+                out[i] = (uint8_t)(i * 11U + pos);
+            }
+            xfade_mix(out, in, CHUNK, pos, total);
+            blocks++;
+        }
+    }
+    cycles = host_cycles() - c0;
+    ns = host_ns() - t0;
+
+    (void)printf("xfade %u B: %6.0f ns, %7.0f cykli na blok, %5.2f cykli na próbkę (z wypełnieniem bloku)\n",
+        CHUNK, (double)ns / blocks, (double)cycles / blocks, (double)cycles / (blocks * (CHUNK / 2U)));
+    return (xfade_stats()->chunks == blocks) ? 0 : 1;
+}
@@ -0,0 +1,44 @@
+#include <time.h>
+
+#include "host.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*!
+ *  @brief    Czas monotoniczny w mikrosekundach.
+ *
+ *  @returns  Mikrosekundy, z przepełnieniem jak getMicros() odtwarzacza
+ */
+uint32_t host_us(void)
+{
+    return (uint32_t)(host_ns() / 1000U);
+}
+
+/*!
+ *  @brief    Czas monotoniczny w nanosekundach.
+ *
+ *  @returns  Nanosekundy od nieokreślonego początku
+ */
+uint64_t host_ns(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+}
+
+/*!
+ *  @brief    Licznik cykli procesora komputera.
+ *
+ *  @returns  Cykle (TSC na x86), 0 gdy licznik nie jest dostępny
+ */
+uint64_t host_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0U;
+#endif
+}
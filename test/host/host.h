@@ -0,0 +1,13 @@
+#ifndef __HOST_H
+#define __HOST_H
+
+#include <stdint.h>
+
+/* Zegar dla modułów przyjmujących funkcję czasu (statystyki w mikrosekundach) */
+uint32_t host_us(void);
+
+/* Czas do pomiarów wydajności */
+uint64_t host_ns(void);
+uint64_t host_cycles(void);
+
+#endif /* __HOST_H */
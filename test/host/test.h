@@ -0,0 +1,40 @@
+#ifndef __TEST_H
+#define __TEST_H
+
+#include <stdio.h>
+
+/* Asercje testów na komputerze; każdy test jest osobnym programem,
+   kod wyjścia 0 gdy wszystkie sprawdzenia przeszły */
+static int testChecks = 0;
+static int testFailures = 0;
+
+#define CHECK(cond) do { \
+        testChecks++; \
+        if (!(cond)) { \
+            (void)printf("%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #cond); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+        long a_ = (long)(actual); \
+        long e_ = (long)(expected); \
+        testChecks++; \
+        if (a_ != e_) { \
+            (void)printf("%s:%d: %s = %ld, oczekiwano %ld\n", __FILE__, __LINE__, #actual, a_, e_); \
+            testFailures++; \
+        } \
+    } while (0)
+
+/*!
+ *  @brief    Wypisuje podsumowanie testu.
+ *
+ *  @returns  Kod wyjścia programu: 0 bez błędów, 1 przy błędach
+ */
+static inline int test_done(const char* name)
+{
+    (void)printf("%s: %d sprawdzeń, %d błędów\n", name, testChecks, testFailures);
+    return (testFailures == 0) ? 0 : 1;
+}
+
+#endif /* __TEST_H */
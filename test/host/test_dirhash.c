@@ -0,0 +1,198 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "ff.h"
+#include "diskio.h"
+
+/*
+ * Tablica skrótów katalogu FatFs (_USE_DIRHASH) na dysku w pamięci.
+ *
+ * Obraz FAT12: sektor rozruchowy, jedna FAT, katalog główny na 512 wpisów
+ * (32 sektory) z FILES plikami F000.WAV ... F299.WAV. Liczba odczytów
+ * sektorów pokazuje, czy f_open poszedł przez tablicę (jeden sektor
+ * katalogu), czy przeszukał katalog od początku.
+ */
+
+#define SECT 512U
+#define ROOT_ENTRIES 512U
+#define ROOT_SECTORS (ROOT_ENTRIES * 32U / SECT)
+#define ROOT_FIRST 2U               /* za sektorem rozruchowym i FAT */
+#define DATA_SECTORS 64U
+#define DISK_SECTORS (ROOT_FIRST + ROOT_SECTORS + DATA_SECTORS)
+#define FILES 300U                  /* więcej niż _DIRHASH_SIZE */
+#define HASHED (_DIRHASH_SIZE / 4U * 3U)
+
+static uint8_t disk[DISK_SECTORS][SECT];
+static uint32_t reads = 0U;
+
+DSTATUS disk_initialize(BYTE drv)
+{
+    return (drv == 0U) ? 0U : STA_NOINIT;
+}
+
+DSTATUS disk_status(BYTE drv)
+{
+    return (drv == 0U) ? 0U : STA_NOINIT;
+}
+
+DRESULT disk_read(BYTE drv, BYTE* buff, DWORD sector, BYTE count)
+{
+    if ((drv != 0U) || ((sector + count) > DISK_SECTORS)) {
+        return RES_PARERR;
+    }
+    (void)memcpy(buff, disk[sector], (size_t)count * SECT);
+    reads += count;
+    return RES_OK;
+}
+
+DRESULT disk_write(BYTE drv, const BYTE* buff, DWORD sector, BYTE count)
+{
+    if ((drv != 0U) || ((sector + count) > DISK_SECTORS)) {
+        return RES_PARERR;
+    }
+    (void)memcpy(disk[sector], buff, (size_t)count * SECT);
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void* buff)
+{
+    return (ctrl == CTRL_SYNC) ? RES_OK : RES_PARERR;
+}
+
+DWORD get_fattime(void)
+{
+    return ((DWORD)(2010U - 1980U) << 25) | (1UL << 21) | (1UL << 16);
+}
+
+static void put16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+/*!
+ *  @brief    Buduje obraz FAT12 z FILES pustymi plikami w katalogu głównym.
+ */
+static void make_image(void)
+{
+    uint8_t* bs = disk[0];
+    uint32_t i;
+
+    (void)memset(disk, 0, sizeof(disk));
+
+    (void)memcpy(&bs[0], "\xEB\x3C\x90" "MSDOS5.0", 11U);
+    put16(&bs[11], SECT);               /* BPB_BytsPerSec */
+    bs[13] = 1U;                        /* BPB_SecPerClus */
+    put16(&bs[14], 1U);                 /* BPB_RsvdSecCnt */
+    bs[16] = 1U;                        /* BPB_NumFATs */
+    put16(&bs[17], ROOT_ENTRIES);       /* BPB_RootEntCnt */
+    put16(&bs[19], DISK_SECTORS);       /* BPB_TotSec16 */
+    bs[21] = 0xF8U;                     /* BPB_Media */
+    put16(&bs[22], 1U);                 /* BPB_FATSz16 */
+    (void)memcpy(&bs[54], "FAT12   ", 8U);
+    bs[510] = 0x55U;
+    bs[511] = 0xAAU;
+
+    disk[1][0] = 0xF8U;
+    disk[1][1] = 0xFFU;
+    disk[1][2] = 0xFFU;
+
+    for (i = 0U; i < FILES; i++) {
+        uint8_t* e = &disk[ROOT_FIRST + (i / 16U)][(i % 16U) * 32U];
+        char name[12];
+
+        (void)snprintf(name, sizeof(name), "F%03u    WAV", (unsigned)i);
+        (void)memcpy(e, name, 11U);
+        e[11] = AM_ARC;
+    }
+}
+
+/*!
+ *  @brief    Otwiera plik i zwraca liczbę odczytanych sektorów.
+ */
+static uint32_t open_reads(const char* path, FRESULT* res)
+{
+    FIL fil;
+    uint32_t before = reads;
+
+    *res = f_open(&fil, path, FA_READ);
+    return reads - before;
+}
+
+int main(void)
+{
+    FATFS fs;
+    DIR dir;
+    FILINFO fno;
+    FRESULT res;
+    uint32_t n;
+    uint32_t r;
+#if _USE_LFN
+    char lfn[_MAX_LFN + 1];
+
+    fno.lfname = lfn;
+    fno.lfsize = sizeof(lfn);
+#endif
+
+    make_image();
+    CHECK_EQ(f_mount(0, &fs), FR_OK);
+
+    /* Bez tablicy: przeszukanie od początku katalogu */
+    r = open_reads("F100.WAV", &res);
+    CHECK_EQ(res, FR_OK);
+    CHECK(r > 1U);
+
+    /* Pełny przegląd katalogu buduje tablicę */
+    CHECK_EQ(f_opendir(&dir, ""), FR_OK);
+    n = 0U;
+    for (;;) {
+        res = f_readdir(&dir, &fno);
+        if ((res != FR_OK) || (fno.fname[0] == '\0')) {
+            break;
+        }
+        n++;
+    }
+    CHECK_EQ(res, FR_OK);
+    CHECK_EQ(n, FILES);
+
+    /* Pliki w tablicy: jeden sektor katalogu */
+    r = open_reads("F000.WAV", &res);
+    CHECK_EQ(res, FR_OK);
+    CHECK_EQ(r, 1U);
+    r = open_reads("F100.WAV", &res);
+    CHECK_EQ(res, FR_OK);
+    CHECK_EQ(r, 1U);
+    r = open_reads("F100.WAV", &res);
+    CHECK_EQ(res, FR_OK);
+    CHECK_EQ(r, 0U);
+    r = open_reads("F191.WAV", &res);
+    CHECK_EQ(res, FR_OK);
+    CHECK_EQ(r, 1U);
+
+    /* Za progiem zapełnienia tablica zostaje, plik znajduje przeszukanie */
+    CHECK_EQ(HASHED, 192U);
+    r = open_reads("F250.WAV", &res);
+    CHECK_EQ(res, FR_OK);
+    CHECK(r > 1U);
+    r = open_reads("F299.WAV", &res);
+    CHECK_EQ(res, FR_OK);
+    r = open_reads("F050.WAV", &res);
+    CHECK_EQ(res, FR_OK);
+    CHECK_EQ(r, 1U);
+
+    /* Brak pliku i nazwa spoza 8.3 */
+    r = open_reads("NONE.WAV", &res);
+    CHECK_EQ(res, FR_NO_FILE);
+    r = open_reads("f100.wav", &res);
+    CHECK_EQ(res, FR_OK);
+
+    /* Ponowne zamontowanie unieważnia tablicę */
+    CHECK_EQ(f_mount(0, &fs), FR_OK);
+    r = open_reads("F100.WAV", &res);
+    CHECK_EQ(res, FR_OK);
+    CHECK(r > 2U);
+
+    return test_done("test_dirhash");
+}
@@ -0,0 +1,106 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "fft.h"
+
+#define N 128U
+#define LOG2N 7U
+
+static int16_t re[N];
+static int16_t im[N];
+
+/*!
+ *  @brief    Wypełnia blok sinusem o całkowitej liczbie okresów.
+ */
+static void tone(uint32_t bin, int32_t amp)
+{
+    uint32_t i;
+
+    for (i = 0U; i < N; i++) {
+        re[i] = (int16_t)lround(amp * sin((2.0 * M_PI * bin * i) / N));
+    }
+    (void)memset(im, 0, sizeof(im));
+}
+
+/*!
+ *  @brief    Numer prążka o największym module w pierwszej połowie widma.
+ */
+static uint32_t peak_bin(void)
+{
+    uint32_t k;
+    uint32_t best = 0U;
+    uint16_t m;
+    uint16_t top = 0U;
+
+    for (k = 0U; k < (N / 2U); k++) {
+        m = fft_mag(re[k], im[k]);
+        if (m > top) {
+            top = m;
+            best = k;
+        }
+    }
+    return best;
+}
+
+int main(void)
+{
+    uint32_t bins[] = {1U, 8U, 20U, 63U};
+    uint32_t b;
+    uint32_t k;
+    uint16_t leak;
+
+    /* sinus A na prążku k: moduł A/2 po skalowaniu 1/N, reszta widma bliska zeru */
+    for (b = 0U; b < (sizeof(bins) / sizeof(bins[0])); b++) {
+        tone(bins[b], 16384);
+        fft_q15(re, im, LOG2N);
+        CHECK_EQ(peak_bin(), bins[b]);
+        CHECK(abs((int)fft_mag(re[bins[b]], im[bins[b]]) - 8192) < 820);
+        leak = 0U;
+        for (k = 1U; k < (N / 2U); k++) {
+            if ((k != bins[b]) && (fft_mag(re[k], im[k]) > leak)) {
+                leak = fft_mag(re[k], im[k]);
+            }
+        }
+        CHECK(leak < 64U);
+    }
+
+    /* składowa stała trafia do prążka 0 */
+    for (k = 0U; k < N; k++) {
+        re[k] = 8192;
+        im[k] = 0;
+    }
+    fft_q15(re, im, LOG2N);
+    CHECK(abs(re[0] - 8192) < 16);
+    CHECK_EQ(peak_bin(), 0);
+
+    /* pełna skala bez przepełnienia */
+    for (k = 0U; k < N; k++) {
+        re[k] = ((k & 1U) == 0U) ? 32767 : -32768;
+        im[k] = 0;
+    }
+    fft_q15(re, im, LOG2N);
+    CHECK(fft_mag(re[N / 2U], im[N / 2U]) > 32000U);
+
+    /* okno Hanna: zero na brzegu, pełna wartość w środku */
+    for (k = 0U; k < N; k++) {
+        re[k] = 32767;
+    }
+    fft_window(re, LOG2N);
+    CHECK_EQ(re[0], 0);
+    CHECK(re[N / 2U] > 32700);
+    CHECK_EQ(re[N / 4U], re[(3U * N) / 4U]);
+
+    /* rozmiar spoza zakresu zostawia dane bez zmian */
+    tone(5U, 1000);
+    fft_q15(re, im, FFT_MAX_LOG2N + 1U);
+    CHECK_EQ(re[1], lround(1000 * sin((2.0 * M_PI * 5.0) / N)));
+
+    /* przybliżenie modułu max + min/2 */
+    CHECK_EQ(fft_mag(3000, 0), 3000);
+    CHECK_EQ(fft_mag(-3000, 4000), 5500);
+    CHECK_EQ(fft_mag(-32768, -32768), 49152);
+
+    return test_done("test_fft");
+}
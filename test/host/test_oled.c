@@ -0,0 +1,168 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "oled.h"
+#include "ui.h"
+#include "screen.h"
+
+/* Wzorce w katalogu golden, test uruchamiany jest z katalogu build */
+#define GOLDEN_DIR "../golden/"
+#define GOLDEN_STATS GOLDEN_DIR "screens.txt"
+
+/* 16-bit mono 8 kHz */
+#define BYTES_PER_SEC 16000U
+
+static const char* const names[] = {
+    "01 Intro.wav",
+    "02 Deszcz.wav",
+    "03 Noc w miescie.wav",
+    "04 Pociag.wav",
+    "05 Rano.wav",
+    "06 Most.wav",
+    "07 Bardzo dluga nazwa utworu.wav",
+    "08 Koniec.wav"
+};
+
+static bool update = false;
+static FILE* statsOut = NULL;
+static char statsRef[1024];
+
+/*!
+ *  @brief    Nazwa utworu z listy testowej, NULL za końcem.
+ */
+static const char* name_at(int32_t index)
+{
+    if ((index < 0) || (index >= (int32_t)(sizeof(names) / sizeof(names[0])))) {
+        return NULL;
+    }
+    return names[index];
+}
+
+/*!
+ *  @brief    Porównuje zawartość dwóch plików.
+ *
+ *  @returns  true gdy oba pliki istnieją i są identyczne
+ */
+static bool same_file(const char* a, const char* b)
+{
+    FILE* fa = fopen(a, "rb");
+    FILE* fb = fopen(b, "rb");
+    int ca;
+    int cb;
+    bool same = (fa != NULL) && (fb != NULL);
+
+    while (same == true) {
+        ca = fgetc(fa);
+        cb = fgetc(fb);
+        same = (ca == cb);
+        if (ca == EOF) {
+            break;
+        }
+    }
+    if (fa != NULL) {
+        (void)fclose(fa);
+    }
+    if (fb != NULL) {
+        (void)fclose(fb);
+    }
+    return same;
+}
+
+/*!
+ *  @brief    Rysuje oczekujące zmiany, zapisuje obraz i koszt transmisji,
+ *            porównuje je ze wzorcem.
+ */
+static void snapshot(const char* screen)
+{
+    char out[64];
+    char ref[64];
+    char line[64];
+    oled_stats_t st;
+
+    oled_resetStats();
+    while (ui_task() == true) {
+    }
+    oled_getStats(&st);
+    (void)snprintf(line, sizeof(line), "%s %lu %lu\n", screen,
+        (unsigned long)st.transactions, (unsigned long)st.bytes);
+    (void)printf("  %s", line);
+
+    (void)snprintf(out, sizeof(out), "%s.pbm", screen);
+    (void)snprintf(ref, sizeof(ref), GOLDEN_DIR "%s.pbm", screen);
+    CHECK_EQ(oled_captureWritePbm(out), 0);
+    (void)snprintf(out, sizeof(out), "%s.png", screen);
+    CHECK_EQ(oled_captureWritePng(out), 0);
+
+    if (update == true) {
+        (void)snprintf(out, sizeof(out), "%s.pbm", screen);
+        CHECK_EQ(oled_captureWritePbm(ref), 0);
+        (void)fputs(line, statsOut);
+        return;
+    }
+
+    (void)snprintf(out, sizeof(out), "%s.pbm", screen);
+    if (same_file(out, ref) == false) {
+        (void)printf("%s rozni sie od %s\n", out, ref);
+        CHECK(false);
+    }
+    if (strstr(statsRef, line) == NULL) {
+        (void)printf("koszt %s spoza %s\n", screen, GOLDEN_STATS);
+        CHECK(false);
+    }
+}
+
+int main(void)
+{
+    FILE* f;
+    size_t n;
+
+    /* make golden: zapis nowych wzorców zamiast porównania */
+    update = (getenv("GOLDEN_UPDATE") != NULL);
+    if (update == true) {
+        statsOut = fopen(GOLDEN_STATS, "w");
+        CHECK(statsOut != NULL);
+        if (statsOut == NULL) {
+            return test_done("test_oled");
+        }
+    }
+    else {
+        f = fopen(GOLDEN_STATS, "r");
+        CHECK(f != NULL);
+        if (f != NULL) {
+            n = fread(statsRef, 1U, sizeof(statsRef) - 1U, f);
+            statsRef[n] = '\0';
+            (void)fclose(f);
+        }
+    }
+
+    oled_init();
+    oled_clearScreen(OLED_COLOR_WHITE);
+    ui_init();
+    oled_resetStats();
+    while (ui_task() == true) {
+    }
+
+    /* lista przewinięta do 7. utworu, długa nazwa zaznaczona */
+    screen_list(6, name_at);
+    snapshot("list");
+
+    /* ekran odtwarzania: czas i pasek postępu pod listą */
+    screen_progress(83U * BYTES_PER_SEC, 200U * BYTES_PER_SEC, BYTES_PER_SEC);
+    snapshot("playback");
+
+    /* sekunda później: tylko zmienione cyfry i kolumny paska */
+    screen_progress(84U * BYTES_PER_SEC, 200U * BYTES_PER_SEC, BYTES_PER_SEC);
+    snapshot("playback_tick");
+
+    /* przejście o jeden utwór w dół: dwa wiersze listy */
+    screen_list(7, name_at);
+    snapshot("list_next");
+
+    if (statsOut != NULL) {
+        (void)fclose(statsOut);
+    }
+    return test_done("test_oled");
+}
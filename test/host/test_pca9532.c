@@ -0,0 +1,106 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "test.h"
+#include "lpc17xx_i2c.h"
+#include "i2cq.h"
+#include "pca9532.h"
+
+/* Rejestry układu odtworzone z zapisów I2C (zamiast kolejki i2cq) */
+static uint8_t regs[16];
+
+int i2cq_write(uint8_t addr, uint8_t* buf, uint32_t len)
+{
+    uint8_t reg = buf[0] & 0x0FU;
+    uint32_t i;
+
+    CHECK_EQ(addr, PCA9532_I2C_ADDR);
+    for (i = 1U; i < len; i++) {
+        regs[reg & 0x0FU] = buf[i];
+        if ((buf[0] & PCA9532_AUTO_INC) != 0U) {
+            reg++;
+        }
+    }
+    return 0;
+}
+
+int i2cq_transfer(uint8_t addr, uint8_t* txBuf, uint32_t txLen, uint8_t* rxBuf, uint32_t rxLen)
+{
+    (void)memset(rxBuf, 0, rxLen);
+    return 0;
+}
+
+/*!
+ *  @brief    Tryb diody z rejestrów LS: 0 wył., 1 wł., 2 PWM0, 3 PWM1.
+ */
+static uint8_t mode(uint32_t led)
+{
+    return (uint8_t)((regs[PCA9532_LS0 + (led / 4U)] >> ((led % 4U) * 2U)) & 3U);
+}
+
+/*!
+ *  @brief    Ta sama sekwencja wywołań co led_bar_show() odtwarzacza dla
+ *            8-diodowej linijki: poziom w 1/256 diody.
+ */
+static void bar(uint32_t level)
+{
+    uint32_t full = level >> 8;
+    uint8_t frac = (uint8_t)(level & 0xFFU);
+    uint16_t ledOn = (uint16_t)((1U << full) - 1U);
+
+    pca9532_setDeferred(1);
+    pca9532_setLeds(ledOn, (uint16_t)(0x00FFU & ~ledOn));
+    if ((frac != 0U) && (full < 8U)) {
+        pca9532_setBlink0Pwm(frac);
+        pca9532_setBlink0Leds((uint16_t)(1U << full));
+    }
+    pca9532_setDeferred(0);
+}
+
+/*!
+ *  @brief    Sprawdza tryby diod linijki: pełne włączone, ułamkowa PWM0, reszta wyłączona.
+ */
+static void check_bar(uint32_t level)
+{
+    uint32_t full = level >> 8;
+    uint32_t led;
+    uint8_t want;
+
+    for (led = 0U; led < 8U; led++) {
+        if (led < full) {
+            want = 1U;
+        }
+        else if ((led == full) && ((level & 0xFFU) != 0U)) {
+            want = 2U;
+        }
+        else {
+            want = 0U;
+        }
+        if (mode(led) != want) {
+            (void)printf("poziom %lu: ", (unsigned long)level);
+        }
+        CHECK_EQ(mode(led), want);
+    }
+}
+
+int main(void)
+{
+    static const uint32_t levels[] = {0x380U, 0x500U, 0x2C0U, 0x800U, 0x0U, 0x180U, 0x7FFU, 0x280U};
+    uint32_t i;
+
+    pca9532_init();
+    for (i = 0U; i < (sizeof(levels) / sizeof(levels[0])); i++) {
+        bar(levels[i]);
+        check_bar(levels[i]);
+    }
+    CHECK_EQ(regs[PCA9532_PWM0], 0x80);
+
+    /* miganie zostawione na diodach poza linijką */
+    pca9532_setBlink1Leds(LED12);
+    bar(0x300U);
+    CHECK_EQ(mode(8U), 3U);
+    pca9532_setLeds(LED12, 0U);
+    CHECK_EQ(mode(8U), 1U);
+
+    return test_done("test_pca9532");
+}
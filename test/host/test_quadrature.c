@@ -0,0 +1,94 @@
+#include <stdint.h>
+
+#include "test.h"
+#include "quadrature.h"
+
+/* Stany linii po kolejnych zboczach: A na bicie 1, B na bicie 0 */
+static const uint8_t cw[] = {1U, 0U, 2U, 3U};
+static const uint8_t ccw[] = {2U, 0U, 1U, 3U};
+
+/* Drgania styków na każdym przejściu, nadal jeden zatrzask w prawo */
+static const uint8_t cwBounce[] = {1U, 3U, 1U, 0U, 1U, 0U, 2U, 0U, 2U, 3U};
+
+/* Niedozwolone przejścia (zmiana obu linii naraz) */
+static const uint8_t jump[] = {0U, 2U, 3U};
+static const uint8_t jumpMid[] = {1U, 2U, 3U};
+static const uint8_t jumpLate[] = {2U, 0U, 3U};
+
+/* Powrót w połowie drogi, bez zatrzasku */
+static const uint8_t halfBack[] = {1U, 0U, 1U, 3U};
+
+/* Zbocze bez zmiany stanu linii (zbyt krótki impuls) w środku sekwencji */
+static const uint8_t cwGlitch[] = {1U, 1U, 0U, 0U, 2U, 3U, 3U};
+
+/*!
+ *  @brief    Podaje dekoderowi sekwencję stanów linii jak z przerwania GPIO.
+ *
+ *  @returns  Suma kierunków zwróconych przez quad_update()
+ */
+static int32_t replay(Quadrature_t* q, const uint8_t* ab, uint32_t n)
+{
+    uint32_t i;
+    int32_t sum = 0;
+
+    for (i = 0U; i < n; i++) {
+        sum += quad_update(q, ab[i]);
+    }
+    return sum;
+}
+
+#define REPLAY(q, seq) replay((q), (seq), sizeof(seq))
+
+int main(void)
+{
+    Quadrature_t q;
+    uint32_t i;
+
+    /* czyste zatrzaski w obu kierunkach */
+    quad_init(&q, 3U);
+    CHECK_EQ(REPLAY(&q, cw), 1);
+    CHECK_EQ(REPLAY(&q, cw), 1);
+    CHECK_EQ(REPLAY(&q, ccw), -1);
+    CHECK_EQ(quad_takeDelta(&q), 1);
+    CHECK_EQ(quad_takeDelta(&q), 0);
+    CHECK_EQ(q.edges, 12);
+    CHECK_EQ(q.glitches, 0);
+
+    for (i = 0U; i < 5U; i++) {
+        (void)REPLAY(&q, ccw);
+    }
+    CHECK_EQ(quad_takeDelta(&q), -5);
+
+    /* drgania styków */
+    quad_init(&q, 3U);
+    CHECK_EQ(REPLAY(&q, cwBounce), 1);
+    CHECK_EQ(quad_takeDelta(&q), 1);
+    CHECK_EQ(q.glitches, 0);
+
+    /* niedozwolone skoki nie zmieniają licznika, a następny zatrzask jest liczony */
+    quad_init(&q, 3U);
+    CHECK_EQ(REPLAY(&q, jump), 0);
+    CHECK_EQ(REPLAY(&q, jumpMid), 0);
+    CHECK_EQ(REPLAY(&q, jumpLate), 0);
+    CHECK_EQ(REPLAY(&q, halfBack), 0);
+    CHECK_EQ(REPLAY(&q, ccw), -1);
+    CHECK_EQ(quad_takeDelta(&q), -1);
+    CHECK_EQ(q.edges, 17);
+
+    /* zbocza bez zmiany stanu: zliczane jako zakłócenia, bez wpływu na automat */
+    quad_init(&q, 3U);
+    CHECK_EQ(REPLAY(&q, cwGlitch), 1);
+    CHECK_EQ(q.edges, 7);
+    CHECK_EQ(q.glitches, 3);
+    CHECK_EQ(quad_update(&q, 3U), 0);
+    CHECK_EQ(q.glitches, 4);
+    CHECK_EQ(quad_takeDelta(&q), 1);
+
+    /* start w pozycji innej niż zatrzask: pierwszy niepełny obrót nie jest liczony */
+    quad_init(&q, 0U);
+    CHECK_EQ(quad_update(&q, 2U), 0);
+    CHECK_EQ(quad_update(&q, 3U), 0);
+    CHECK_EQ(REPLAY(&q, cw), 1);
+
+    return test_done("test_quadrature");
+}
@@ -0,0 +1,112 @@
+#include <math.h>
+#include <string.h>
+
+#include "test.h"
+#include "host.h"
+#include "spectrum.h"
+#include "oled.h"
+
+#define RATE_HZ 8000U
+#define HALF_BYTES 256U
+
+/*!
+ *  @brief    Generuje połówkę bufora sinusa 16-bit little-endian.
+ */
+static void tone(uint8_t* pcm, uint32_t freq, uint32_t* phase)
+{
+    uint32_t i;
+    int16_t s;
+
+    for (i = 0U; i < HALF_BYTES; i += 2U) {
+        s = (int16_t)lround(12000.0 * sin((2.0 * M_PI * freq * *phase) / RATE_HZ));
+        pcm[i] = (uint8_t)s;
+        pcm[i + 1U] = (uint8_t)((uint16_t)s >> 8);
+        (*phase)++;
+    }
+}
+
+/*!
+ *  @brief    Wysokość słupka odczytana z przechwyconego ekranu.
+ */
+static uint32_t bar_height(uint32_t bar)
+{
+    uint32_t x = bar * (SPECTRUM_BAR_WIDTH + 1U);
+    uint32_t h = 0U;
+
+    while ((h < (SPECTRUM_ROWS * 8U))
+        && (oled_captureGetPixel((uint8_t)x, (uint8_t)((SPECTRUM_ROWS * 8U) - 1U - h)) == OLED_COLOR_BLACK)) {
+        h++;
+    }
+    return h;
+}
+
+/*!
+ *  @brief    Wykonuje kroki analizatora do bezczynności, sprawdzając transmisję na krok.
+ *
+ *  @returns  Liczba kroków z wykonaną pracą
+ */
+static uint32_t run(uint32_t nowMs)
+{
+    oled_stats_t st;
+    uint32_t steps = 0U;
+
+    oled_resetStats();
+    while (spectrum_task(nowMs) == true) {
+        oled_getStats(&st);
+        CHECK(st.bytes <= (SPECTRUM_ROWS * (3U + SPECTRUM_BAR_WIDTH)));
+        oled_resetStats();
+        steps++;
+    }
+    return steps;
+}
+
+int main(void)
+{
+    uint8_t pcm[HALF_BYTES];
+    uint32_t phase = 0U;
+    uint32_t b;
+    uint32_t top = 0U;
+    uint32_t topBar = 0U;
+
+    oled_init();
+    oled_clearScreen(OLED_COLOR_WHITE);
+    spectrum_init(host_us);
+
+    /* blok FFT zbierany z dwóch połówek bufora po decymacji */
+    tone(pcm, 1000U, &phase);
+    spectrum_feed(pcm, sizeof(pcm));
+    CHECK(spectrum_task(0U) == false);
+    tone(pcm, 1000U, &phase);
+    spectrum_feed(pcm, sizeof(pcm));
+    CHECK(run(0U) > 1U);
+    CHECK_EQ(spectrum_stats()->frames, 1);
+
+    /* 1 kHz przy 4 kHz po decymacji: prążek 32 z 64, pasmo 13 (bez decymacji byłoby 11) */
+    for (b = 0U; b < SPECTRUM_BARS; b++) {
+        if (bar_height(b) > top) {
+            top = bar_height(b);
+            topBar = b;
+        }
+    }
+    CHECK_EQ(topBar, 13);
+    CHECK(top > 24U);
+    CHECK(bar_height(3U) < (top / 2U));
+
+    /* blok nie jest pobierany przed upływem odstępu między klatkami */
+    tone(pcm, 1000U, &phase);
+    spectrum_feed(pcm, sizeof(pcm));
+    spectrum_feed(pcm, sizeof(pcm));
+    CHECK_EQ(run(1U), 0);
+    CHECK_EQ(spectrum_stats()->frames, 1);
+
+    /* po odstępie: cisza, słupki opadają o 2 piksele na klatkę */
+    (void)memset(pcm, 0, sizeof(pcm));
+    CHECK_EQ(run(SPECTRUM_MIN_INTERVAL_MS), 0);
+    spectrum_feed(pcm, sizeof(pcm));
+    spectrum_feed(pcm, sizeof(pcm));
+    CHECK(run(SPECTRUM_MIN_INTERVAL_MS) > 1U);
+    CHECK_EQ(spectrum_stats()->frames, 2);
+    CHECK_EQ(bar_height(topBar), top - 2U);
+
+    return test_done("test_spectrum");
+}
@@ -0,0 +1,290 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "sdstream.h"
+
+/*
+ * Symulacja doczytywania bufora w trakcie przejścia między utworami.
+ *
+ * f_read poniżej odtwarza zachowanie FatFs R0.07e z _FS_TINY: od granicy
+ * sektora, gdy zostało co najmniej 512 bajtów, sektory idą prosto do bufora
+ * użytkownika; część sektora i tablica FAT idą przez jedno wspólne okno.
+ * Każde załadowanie sektora kosztuje opóźnienie karty i transmisję SPI.
+ *
+ * Porównywane są trzy sposoby odczytu: f_read po 256 bajtów z obu plików,
+ * sdstream bez doczytywania z wyprzedzeniem i sdstream z sds_topUp() po
+ * każdej połówce, tak jak w task_audio().
+ */
+
+#define SECT 512U
+#define CLUSTER_SECTORS 64U         /* klaster 32 KB */
+#define HEADER 44U                  /* nagłówek WAV */
+#define HALF 256U                   /* połówka bufora odtwarzacza */
+#define BYTES_PER_SEC 16000U        /* 8 kHz, 16 bit, mono */
+#define XFADE_S 10U                 /* najdłuższe przejście */
+
+/* SSP1 1 MHz: 8 us na bajt; sektor z tokenem, CRC i komendą ~522 bajty */
+#define SPI_BYTE_US 8U
+#define SECTOR_XFER_US (522U * SPI_BYTE_US)
+
+/* Połówka odtwarzana jest w 16 ms; zapas na krok interfejsu rozpoczęty przed
+   zwolnieniem połówki i mieszanie */
+#define HALF_US ((HALF / 2U) * 125U)
+#define OTHER_WORK_US 2000U
+
+#define WIN_NONE 0xFFFFFFFFUL
+#define FAT_SECT 0x80000000UL
+
+typedef enum {
+    READ_FREAD = 0,
+    READ_STREAM,
+    READ_STREAM_AHEAD
+} ReadMode;
+
+typedef struct {
+    uint32_t sectors;       /* sektory przesłane z karty */
+    uint32_t worstUs;       /* najdłuższe doczytanie połówki */
+    uint32_t underruns;
+    uint32_t badData;
+} SimResult;
+
+static uint32_t winSect = WIN_NONE;
+static uint32_t sectors = 0U;
+static uint32_t busyUs = 0U;
+static uint32_t rng = 1U;
+
+/*!
+ *  @brief    Opóźnienie odpowiedzi karty: 0,3-1 ms, co 128. odczyt 6 ms
+ *            (zajętość karty przy porządkowaniu pamięci flash).
+ */
+static uint32_t latency_us(void)
+{
+    rng = (rng * 1103515245UL) + 12345UL;
+    if ((sectors % 128U) == 127U) {
+        return 6000U;
+    }
+    return 300U + ((rng >> 16) % 700U);
+}
+
+static void card_read(void)
+{
+    busyUs += latency_us() + SECTOR_XFER_US;
+    sectors++;
+}
+
+static void window_load(uint32_t id)
+{
+    if (winSect != id) {
+        card_read();
+        winSect = id;
+    }
+}
+
+/*!
+ *  @brief    Zawartość pliku - sprawdzana po stronie odtwarzacza.
+ */
+static uint8_t pattern(uint32_t file, uint32_t ofs)
+{
+    return (uint8_t)((ofs * 31U) ^ (ofs >> 9) ^ (file * 77U));
+}
+
+static void copy_out(const FIL* fp, uint8_t* d, uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0U; i < n; i++) {
+        d[i] = pattern(fp->org_clust, fp->fptr + i);
+    }
+}
+
+FRESULT f_read(FIL* fp, void* buff, UINT btr, UINT* br)
+{
+    uint8_t* d = buff;
+    uint32_t sect;
+    uint32_t cc;
+    uint32_t i;
+    uint32_t rcnt;
+
+    *br = 0U;
+    if (btr > (fp->fsize - fp->fptr)) {
+        btr = fp->fsize - fp->fptr;
+    }
+    while (btr > 0U) {
+        sect = fp->fptr / SECT;
+        if ((fp->fptr % SECT) == 0U) {
+            if ((sect > 0U) && ((sect % CLUSTER_SECTORS) == 0U)) {
+                /* get_fat: sektor tablicy FAT przez okno */
+                window_load(FAT_SECT | (fp->org_clust << 16) | (sect / (CLUSTER_SECTORS * 128U)));
+            }
+            cc = btr / SECT;
+            if (cc > 0U) {
+                if (((sect % CLUSTER_SECTORS) + cc) > CLUSTER_SECTORS) {
+                    cc = CLUSTER_SECTORS - (sect % CLUSTER_SECTORS);
+                }
+                for (i = 0U; i < cc; i++) {
+                    card_read();
+                }
+                rcnt = cc * SECT;
+                copy_out(fp, d, rcnt);
+                d += rcnt;
+                fp->fptr += rcnt;
+                *br += rcnt;
+                btr -= rcnt;
+                continue;
+            }
+        }
+        window_load((fp->org_clust << 20) | sect);
+        rcnt = SECT - (fp->fptr % SECT);
+        if (rcnt > btr) {
+            rcnt = btr;
+        }
+        copy_out(fp, d, rcnt);
+        d += rcnt;
+        fp->fptr += rcnt;
+        *br += rcnt;
+        btr -= rcnt;
+    }
+    return FR_OK;
+}
+
+static void open_file(FIL* fp, uint32_t id, uint32_t dataSize, uint32_t pos)
+{
+    (void)memset(fp, 0, sizeof(*fp));
+    fp->org_clust = id;
+    fp->fsize = HEADER + dataSize;
+    fp->fptr = HEADER + pos;
+}
+
+static bool check_data(uint32_t file, uint32_t ofs, const uint8_t* d, uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0U; i < n; i++) {
+        if (d[i] != pattern(file, ofs + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ *  @brief    Przejście XFADE_S sekund: każda połówka czyta HALF bajtów z obu plików.
+ *  @param mode
+ *            Sposób odczytu
+ *  @param curStart
+ *            Położenie początku przejścia w danych bieżącego utworu
+ */
+static SimResult simulate(ReadMode mode, uint32_t curStart)
+{
+    static SdStream_t cur;
+    static SdStream_t nxt;
+    FIL fCur;
+    FIL fNext;
+    uint8_t a[HALF];
+    uint8_t b[HALF];
+    UINT br;
+    uint32_t got;
+    uint32_t half;
+    uint32_t halves = (XFADE_S * BYTES_PER_SEC) / HALF;
+    uint32_t freeAt;
+    uint32_t start;
+    uint32_t done = 0U;
+    uint32_t readyUs;
+    SimResult r;
+
+    (void)memset(&r, 0, sizeof(r));
+    winSect = WIN_NONE;
+    sectors = 0U;
+    rng = 1U;
+
+    open_file(&fCur, 1U, curStart + (XFADE_S * BYTES_PER_SEC), curStart);
+    open_file(&fNext, 2U, 60U * BYTES_PER_SEC, 0U);
+    sds_attach(&cur, &fCur);
+    sds_attach(&nxt, &fNext);
+
+    for (half = 0U; half < halves; half++) {
+        busyUs = 0U;
+        if (mode == READ_FREAD) {
+            (void)f_read(&fCur, a, HALF, &br);
+            (void)f_read(&fNext, b, HALF, &br);
+        }
+        else {
+            (void)sds_read(&cur, a, HALF, &got);
+            (void)sds_read(&nxt, b, HALF, &got);
+        }
+        readyUs = busyUs;
+        if (mode == READ_STREAM_AHEAD) {
+            if (sds_buffered(&nxt) < sds_buffered(&cur)) {
+                (void)sds_topUp(&nxt);
+            }
+            else {
+                (void)sds_topUp(&cur);
+            }
+        }
+        if ((check_data(1U, HEADER + curStart + (half * HALF), a, HALF) == false)
+            || (check_data(2U, HEADER + (half * HALF), b, HALF) == false)) {
+            r.badData++;
+        }
+
+        /* połówka zwalniana co HALF_US; musi być gotowa przed końcem drugiej,
+           odczyt z wyprzedzeniem zajmuje zadanie już po oznaczeniu połówki jako gotowej */
+        freeAt = half * HALF_US;
+        start = (done > freeAt) ? done : freeAt;
+        if ((start + readyUs + OTHER_WORK_US) > (freeAt + HALF_US)) {
+            r.underruns++;
+            start = freeAt;
+        }
+        done = start + busyUs;
+        if ((start + readyUs - freeAt) > r.worstUs) {
+            r.worstUs = start + readyUs - freeAt;
+        }
+    }
+    r.sectors = sectors;
+    return r;
+}
+
+static void report(const char* name, const SimResult* r)
+{
+    (void)printf("  %-20s %5lu sektorow, %5.1f KB/s z karty, gotowa najpozniej po %5.2f ms, niedobory %lu\n", name,
+        (unsigned long)r->sectors, (r->sectors * 0.5) / XFADE_S, r->worstUs / 1000.0,
+        (unsigned long)r->underruns);
+}
+
+int main(void)
+{
+    /* różne położenia początku przejścia względem sektora */
+    static const uint32_t starts[] = {0U, 212U, 468U, 100000U};
+    SimResult oldRead;
+    SimResult plain;
+    SimResult stream;
+    uint32_t i;
+    uint32_t payloadSectors = (2U * XFADE_S * BYTES_PER_SEC) / SECT;
+
+    (void)printf("przejscie %u s, potrzeba %u sektorow (%u KB/s)\n", XFADE_S,
+        (unsigned)payloadSectors, (unsigned)((2U * BYTES_PER_SEC) / 1000U));
+    for (i = 0U; i < (sizeof(starts) / sizeof(starts[0])); i++) {
+        (void)printf("start %lu:\n", (unsigned long)starts[i]);
+        oldRead = simulate(READ_FREAD, starts[i]);
+        plain = simulate(READ_STREAM, starts[i]);
+        stream = simulate(READ_STREAM_AHEAD, starts[i]);
+        report("f_read 256 B", &oldRead);
+        report("sdstream", &plain);
+        report("sdstream + topUp", &stream);
+
+        CHECK_EQ(oldRead.badData, 0);
+        CHECK_EQ(plain.badData, 0);
+        CHECK_EQ(stream.badData, 0);
+        CHECK_EQ(stream.underruns, 0);
+        /* sektor danych tylko raz, plus FAT co klaster i początkowe części sektorów */
+        CHECK(stream.sectors <= (payloadSectors + (payloadSectors / CLUSTER_SECTORS) + 4U));
+        CHECK(oldRead.sectors > (2U * stream.sectors));
+    }
+    (void)printf("odczyty strumieni: %lu sektorow (%lu z wyprzedzeniem), %lu czesciowych\n",
+        (unsigned long)sds_stats()->sectors, (unsigned long)sds_stats()->ahead,
+        (unsigned long)sds_stats()->partial);
+
+    return test_done("test_underrun");
+}
@@ -0,0 +1,115 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "host.h"
+#include "xfade.h"
+
+#define CHUNK 256U
+#define FADE_BYTES (192U * CHUNK)     /* ~3 s, całe bloki */
+
+/*!
+ *  @brief    Wypełnia blok stałą wartością próbek 16-bit little-endian.
+ */
+static void fill(uint8_t* p, int16_t v, uint32_t len)
+{
+    uint32_t i;
+
+    for (i = 0U; i < len; i += 2U) {
+        p[i] = (uint8_t)v;
+        p[i + 1U] = (uint8_t)((uint16_t)v >> 8);
+    }
+}
+
+static int32_t sample(const uint8_t* p, uint32_t i)
+{
+    return (int16_t)(p[2U * i] | (p[(2U * i) + 1U] << 8));
+}
+
+int main(void)
+{
+    uint8_t out[CHUNK];
+    uint8_t in[CHUNK];
+    uint32_t pos;
+    uint32_t i;
+    int32_t prev = 0;
+    int32_t s;
+    bool monotonic = true;
+    bool smooth = true;
+
+    xfade_init(host_us);
+
+    /* wygaszany strumień: od pełnej wartości do zera, bez skoków między blokami */
+    for (pos = 0U; pos < FADE_BYTES; pos += CHUNK) {
+        fill(out, 16384, CHUNK);
+        fill(in, 0, CHUNK);
+        xfade_mix(out, in, CHUNK, pos, FADE_BYTES);
+        for (i = 0U; i < (CHUNK / 2U); i++) {
+            s = sample(out, i);
+            if ((pos == 0U) && (i == 0U)) {
+                CHECK(s > 16300);
+            }
+            else {
+                monotonic = monotonic && (s <= prev);
+                smooth = smooth && ((prev - s) < 16);
+            }
+            prev = s;
+        }
+    }
+    CHECK(monotonic == true);
+    CHECK(smooth == true);
+    CHECK(prev < 64);
+    CHECK_EQ(xfade_stats()->chunks, FADE_BYTES / CHUNK);
+
+    /* narastający strumień: od zera do pełnej wartości */
+    monotonic = true;
+    for (pos = 0U; pos < FADE_BYTES; pos += CHUNK) {
+        fill(out, 0, CHUNK);
+        fill(in, 16384, CHUNK);
+        xfade_mix(out, in, CHUNK, pos, FADE_BYTES);
+        for (i = 0U; i < (CHUNK / 2U); i++) {
+            s = sample(out, i);
+            if ((pos == 0U) && (i == 0U)) {
+                CHECK(s < 64);
+            }
+            else {
+                monotonic = monotonic && (s >= prev);
+            }
+            prev = s;
+        }
+    }
+    CHECK(monotonic == true);
+    CHECK(prev > 16300);
+
+    /* równa moc: w połowie oba wzmocnienia ~0.707, suma dwóch takich samych ~1.414 */
+    fill(out, 10000, CHUNK);
+    fill(in, 10000, CHUNK);
+    xfade_mix(out, in, CHUNK, FADE_BYTES / 2U, FADE_BYTES);
+    CHECK(abs(sample(out, 0U) - 14142) < 60);
+
+    /* przesterowanie: obcięcie do zakresu 16 bitów i licznik */
+    fill(out, 32767, CHUNK);
+    fill(in, 32767, CHUNK);
+    xfade_mix(out, in, CHUNK, FADE_BYTES / 2U, FADE_BYTES);
+    CHECK_EQ(sample(out, 0U), 32767);
+    CHECK_EQ(xfade_stats()->clipped, CHUNK / 2U);
+    fill(out, -32768, CHUNK);
+    fill(in, -32768, CHUNK);
+    xfade_mix(out, in, CHUNK, FADE_BYTES / 2U, FADE_BYTES);
+    CHECK_EQ(sample(out, 5U), -32768);
+
+    /* najdłuższe przejście: położenie na krzywej bez przepełnienia 32 bitów */
+    fill(out, 0, CHUNK);
+    fill(in, 16384, CHUNK);
+    xfade_mix(out, in, CHUNK, (XFADE_MAX_S * 16000U) - CHUNK, XFADE_MAX_S * 16000U);
+    CHECK(sample(out, (CHUNK / 2U) - 1U) > 16300);
+
+    /* pusty blok i zerowa długość nic nie zmieniają */
+    fill(out, 1234, CHUNK);
+    xfade_mix(out, in, 0U, 0U, FADE_BYTES);
+    xfade_mix(out, in, CHUNK, 0U, 0U);
+    CHECK_EQ(sample(out, 0U), 1234);
+
+    return test_done("test_xfade");
+}
@@ -0,0 +1,257 @@
+#include "lpc17xx_gpio.h"
+#include "amp.h"
+
+/* Piny sterujące LM4811 */
+#define AMP_CLK_PORT 0U
+#define AMP_CLK_PIN 27U
+#define AMP_UPDN_PORT 0U
+#define AMP_UPDN_PIN 28U
+#define AMP_SHDN_PORT 2U
+#define AMP_SHDN_PIN 13U
+
+/* Szerokość połówki impulsu CLK (pętla, ~1 us przy 100 MHz) */
+#define AMP_PULSE_LOOPS 25U
+
+/* Dostrojenie -0, -1, -2 dB w Q15 */
+static const int32_t trimTable[AMP_STEP_DB] = {AMP_TRIM_UNITY, 29205, 26029};
+
+/* Śledzony stan kroku wzmacniacza - zmiany wysyłane są jako różnica impulsów */
+static uint8_t step = 0U;
+static uint8_t target = 0U;
+static bool isShutdown = false;
+static bool ramping = false;
+static uint32_t lastRampMs = 0U;
+static uint32_t pulses = 0U;
+
+/*!
+ *  @brief    Krótkie opóźnienie dla impulsu zegara LM4811.
+ *
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static void pulse_delay(void)
+{
+    volatile uint32_t i;
+
+    for (i = 0U; i < AMP_PULSE_LOOPS; i++) {
+        /* odczekanie */
+    }
+}
+
+/*!
+ *  @brief    Zmienia wzmocnienie o podaną liczbę kroków.
+ *  @param up
+ *            true - w górę, false - w dół
+ *  @param n
+ *            Liczba impulsów CLK
+ *
+ *  @side effects:
+ *            LM4811 zmienia krok na narastającym zboczu CLK, kierunek z linii UP/DN.
+ */
+static void pulse(bool up, uint8_t n)
+{
+    uint8_t i;
+
+    if (up == true) {
+        GPIO_SetValue(AMP_UPDN_PORT, 1UL << AMP_UPDN_PIN);
+    }
+    else {
+        GPIO_ClearValue(AMP_UPDN_PORT, 1UL << AMP_UPDN_PIN);
+    }
+    pulse_delay();
+
+    for (i = 0U; i < n; i++) {
+        GPIO_SetValue(AMP_CLK_PORT, 1UL << AMP_CLK_PIN);
+        pulse_delay();
+        GPIO_ClearValue(AMP_CLK_PORT, 1UL << AMP_CLK_PIN);
+        pulse_delay();
+        pulses++;
+    }
+}
+
+/*!
+ *  @brief    Inicjalizuje wzmacniacz LM4811 i synchronizuje śledzony krok.
+ *
+ *  @side effects:
+ *            Konfiguruje piny CLK, UP/DN i SHUTDN jako wyjścia, włącza wzmacniacz.
+ *            Stan po włączeniu zasilania nie jest znany, więc 15 impulsów w dół
+ *            ustawia krok 0 (wzmacniacz nasyca się na minimum).
+ */
+void amp_init(void)
+{
+    GPIO_SetDir(AMP_CLK_PORT, 1UL << AMP_CLK_PIN, 1U);
+    GPIO_SetDir(AMP_UPDN_PORT, 1UL << AMP_UPDN_PIN, 1U);
+    GPIO_SetDir(AMP_SHDN_PORT, 1UL << AMP_SHDN_PIN, 1U);
+
+    GPIO_ClearValue(AMP_CLK_PORT, 1UL << AMP_CLK_PIN);
+    GPIO_ClearValue(AMP_UPDN_PORT, 1UL << AMP_UPDN_PIN);
+
+    /* Wzmacniacz aktywny: SHUTDN = 0 */
+    GPIO_ClearValue(AMP_SHDN_PORT, 1UL << AMP_SHDN_PIN);
+
+    pulse(false, (uint8_t)(AMP_STEPS - 1U));
+    step = 0U;
+    target = 0U;
+    isShutdown = false;
+    ramping = false;
+    pulses = 0U;
+}
+
+/*!
+ *  @brief    Przesuwa krok wzmacniacza do celu.
+ *
+ *  @side effects:
+ *            Wysyła różnicę impulsów, chyba że wzmacniacz jest wyłączony
+ *            albo trwa narastanie po włączeniu (wtedy zapamiętuje tylko cel).
+ */
+static void apply_target(void)
+{
+    if ((isShutdown == true) || (ramping == true)) {
+        return;
+    }
+    if (target > step) {
+        pulse(true, (uint8_t)(target - step));
+    }
+    else if (target < step) {
+        pulse(false, (uint8_t)(step - target));
+    }
+    else {
+        /* krok bez zmian */
+    }
+    step = target;
+}
+
+/*!
+ *  @brief    Wyłącza albo włącza wzmacniacz linią SHUTDN.
+ *  @param on
+ *            true - wyłączenie (SHUTDN = 1), false - włączenie
+ *
+ *  @side effects:
+ *            Po włączeniu krok jest synchronizowany na 0 (-33 dB), a amp_tick()
+ *            podnosi go do celu krok po kroku, więc włączenie nie daje trzasku.
+ */
+void amp_shutdown(bool on)
+{
+    if (on == isShutdown) {
+        return;
+    }
+    if (on == true) {
+        GPIO_SetValue(AMP_SHDN_PORT, 1UL << AMP_SHDN_PIN);
+        isShutdown = true;
+        ramping = false;
+    }
+    else {
+        GPIO_ClearValue(AMP_SHDN_PORT, 1UL << AMP_SHDN_PIN);
+        isShutdown = false;
+        pulse(false, (uint8_t)(AMP_STEPS - 1U));
+        step = 0U;
+        ramping = (target > 0U);
+    }
+}
+
+/*!
+ *  @brief    Krok narastania wzmocnienia, wywoływana z zadania okresowego.
+ *  @param nowMs
+ *            Aktualny czas w milisekundach
+ *
+ *  @returns  true jeśli narastanie właśnie się zakończyło
+ *  @side effects:
+ *            Co AMP_RAMP_MS podnosi wzmocnienie o jeden krok (3 dB).
+ */
+bool amp_tick(uint32_t nowMs)
+{
+    if (ramping == false) {
+        return false;
+    }
+    if ((nowMs - lastRampMs) < AMP_RAMP_MS) {
+        return false;
+    }
+    lastRampMs = nowMs;
+
+    if (step < target) {
+        pulse(true, 1U);
+        step++;
+    }
+    else if (step > target) {
+        /* cel obniżony w trakcie narastania */
+        pulse(false, (uint8_t)(step - target));
+        step = target;
+    }
+    else {
+        /* cel osiągnięty */
+    }
+
+    if (step == target) {
+        ramping = false;
+        return true;
+    }
+    return false;
+}
+
+/*!
+ *  @brief    Sprawdza czy trwa narastanie wzmocnienia po włączeniu.
+ *
+ *  @returns  true w trakcie narastania
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+bool amp_ramping(void)
+{
+    return ramping;
+}
+
+/*!
+ *  @brief    Ustawia głośność: krok wzmacniacza plus dostrojenie cyfrowe.
+ *  @param volume
+ *            Poziom 0-100; 100 to +12 dB, każdy punkt to około 0,47 dB mniej
+ *
+ *  @returns  Mnożnik Q15 dla próbek: AMP_TRIM_UNITY gdy dostrojenie nie jest
+ *            potrzebne, 0 dla wyciszenia
+ *  @side effects:
+ *            Wysyła do LM4811 tylko różnicę kroków względem śledzonego stanu.
+ *            Gdy wzmacniacz jest wyłączony albo narasta, zapamiętuje tylko cel.
+ */
+int32_t amp_setVolume(uint8_t volume)
+{
+    uint32_t att;
+
+    if (volume == 0U) {
+        target = 0U;
+        apply_target();
+        return 0;
+    }
+    if (volume > 100U) {
+        volume = 100U;
+    }
+
+    /* tłumienie względem maksimum w dB */
+    att = (((100U - (uint32_t)volume) * AMP_RANGE_DB) + 50U) / 100U;
+    target = (uint8_t)((AMP_STEPS - 1U) - (att / AMP_STEP_DB));
+    apply_target();
+
+    return trimTable[att % AMP_STEP_DB];
+}
+
+/*!
+ *  @brief    Zwraca śledzony krok wzmacniacza.
+ *
+ *  @returns  Krok 0-15
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+uint8_t amp_step(void)
+{
+    return step;
+}
+
+/*!
+ *  @brief    Zwraca liczbę impulsów CLK wysłanych od inicjalizacji.
+ *
+ *  @returns  Liczba impulsów
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+uint32_t amp_pulses(void)
+{
+    return pulses;
+}
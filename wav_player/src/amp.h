@@ -0,0 +1,26 @@
+#ifndef __AMP_H
+#define __AMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* LM4811: 16 kroków wzmocnienia po 3 dB, od -33 dB (krok 0) do +12 dB (krok 15) */
+#define AMP_STEPS 16U
+#define AMP_STEP_DB 3U
+
+/* Dokładne dostrojenie cyfrowe w krokach 1 dB wewnątrz kroku wzmacniacza */
+#define AMP_TRIM_UNITY 32768
+#define AMP_RANGE_DB (((AMP_STEPS - 1U) * AMP_STEP_DB) + (AMP_STEP_DB - 1U))
+
+/* Narastanie wzmocnienia po wyjściu z wyłączenia: jeden krok co AMP_RAMP_MS */
+#define AMP_RAMP_MS 4U
+
+void amp_init(void);
+int32_t amp_setVolume(uint8_t volume);
+void amp_shutdown(bool on);
+bool amp_tick(uint32_t nowMs);
+bool amp_ramping(void);
+uint8_t amp_step(void);
+uint32_t amp_pulses(void);
+
+#endif /* __AMP_H */
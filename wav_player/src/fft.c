@@ -0,0 +1,163 @@
+#include "fft.h"
+
+/* Ćwiartka sinusa dla 256 punktów w Q15: sin(2*pi*k/256), k = 0..64 */
+static const int16_t sinTable[65] = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602,
+    6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767
+};
+
+/*!
+ *  @brief    Zwraca sinus kąta 2*pi*k/256 w Q15.
+ *  @param k
+ *            Indeks kąta (0 - 255)
+ *
+ *  @returns  int16_t z wartością sinusa
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static int16_t sin256(uint32_t k)
+{
+    uint32_t r = k & 63U;
+    int16_t v;
+
+    switch ((k >> 6) & 3U) {
+    case 0U:
+        v = sinTable[r];
+        break;
+    case 1U:
+        v = sinTable[64U - r];
+        break;
+    case 2U:
+        v = (int16_t)-sinTable[r];
+        break;
+    default:
+        v = (int16_t)-sinTable[64U - r];
+        break;
+    }
+    return v;
+}
+
+/*!
+ *  @brief    Mnożenie dwóch liczb Q15.
+ *
+ *  @returns  int32_t z iloczynem w Q15
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static inline int32_t mul_q15(int32_t a, int32_t b)
+{
+    return (a * b) >> 15;
+}
+
+/*!
+ *  @brief    Nakłada okno Hanna na blok próbek.
+ *  @param re
+ *            Blok próbek w Q15 o długości 2^log2n
+ *  @param log2n
+ *            Logarytm długości bloku
+ *
+ *  @side effects:
+ *            Modyfikuje próbki w miejscu.
+ */
+void fft_window(int16_t* re, uint8_t log2n)
+{
+    uint32_t n = 1UL << log2n;
+    uint32_t shift = 8U - log2n;
+    uint32_t i;
+    int32_t w;
+
+    for (i = 0U; i < n; i++) {
+        /* w = 0.5 - 0.5 * cos(2*pi*i/n) */
+        w = (32768 - (int32_t)sin256((i << shift) + 64U)) >> 1;
+        re[i] = (int16_t)mul_q15(re[i], w);
+    }
+}
+
+/*!
+ *  @brief    Wykonuje FFT radix-2 (decymacja w czasie) na liczbach stałoprzecinkowych Q15.
+ *  @param re
+ *            Część rzeczywista, 2^log2n elementów
+ *  @param im
+ *            Część urojona, 2^log2n elementów
+ *  @param log2n
+ *            Logarytm długości transformaty (FFT_MIN_LOG2N - FFT_MAX_LOG2N)
+ *
+ *  @side effects:
+ *            Wynik zapisywany w miejscu, podzielony przez 2^log2n
+ *            (skalowanie 1/2 na każdym etapie zapobiega przepełnieniu).
+ */
+void fft_q15(int16_t* re, int16_t* im, uint8_t log2n)
+{
+    uint32_t n = 1UL << log2n;
+    uint32_t i;
+    uint32_t j;
+    uint32_t k;
+    uint32_t bit;
+    uint32_t half;
+    uint32_t step;
+    int32_t wr;
+    int32_t wi;
+    int32_t tr;
+    int32_t ti;
+    int16_t tmp;
+
+    if ((log2n < FFT_MIN_LOG2N) || (log2n > FFT_MAX_LOG2N)) {
+        return;
+    }
+
+    /* Permutacja bit-reversal */
+    j = 0U;
+    for (i = 0U; i < (n - 1U); i++) {
+        if (i < j) {
+            tmp = re[i]; re[i] = re[j]; re[j] = tmp;
+            tmp = im[i]; im[i] = im[j]; im[j] = tmp;
+        }
+        bit = n >> 1;
+        while ((j & bit) != 0U) {
+            j ^= bit;
+            bit >>= 1;
+        }
+        j |= bit;
+    }
+
+    /* Etapy motylków, krok kąta w jednostkach 2*pi/256 */
+    for (half = 1U; half < n; half <<= 1) {
+        step = 128U / half;
+        for (k = 0U; k < half; k++) {
+            wr = sin256((k * step) + 64U);
+            wi = -sin256(k * step);
+            for (i = k; i < n; i += (half << 1)) {
+                j = i + half;
+                tr = mul_q15(wr, re[j]) - mul_q15(wi, im[j]);
+                ti = mul_q15(wr, im[j]) + mul_q15(wi, re[j]);
+                re[j] = (int16_t)((re[i] - tr) >> 1);
+                im[j] = (int16_t)((im[i] - ti) >> 1);
+                re[i] = (int16_t)((re[i] + tr) >> 1);
+                im[i] = (int16_t)((im[i] + ti) >> 1);
+            }
+        }
+    }
+}
+
+/*!
+ *  @brief    Przybliżony moduł liczby zespolonej (max + min/2).
+ *
+ *  @returns  uint16_t z modułem, błąd poniżej 12%
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+uint16_t fft_mag(int16_t re, int16_t im)
+{
+    uint32_t a = (re < 0) ? (uint32_t)(-(int32_t)re) : (uint32_t)re;
+    uint32_t b = (im < 0) ? (uint32_t)(-(int32_t)im) : (uint32_t)im;
+    uint32_t m = (a > b) ? (a + (b >> 1)) : (b + (a >> 1));
+
+    return (m > 0xFFFFU) ? 0xFFFFU : (uint16_t)m;
+}
@@ -0,0 +1,14 @@
+#ifndef __FFT_H
+#define __FFT_H
+
+#include <stdint.h>
+
+/* Obsługiwane rozmiary transformaty: 64 - 256 punktów */
+#define FFT_MIN_LOG2N 6U
+#define FFT_MAX_LOG2N 8U
+
+void fft_window(int16_t* re, uint8_t log2n);
+void fft_q15(int16_t* re, int16_t* im, uint8_t log2n);
+uint16_t fft_mag(int16_t re, int16_t im);
+
+#endif /* __FFT_H */
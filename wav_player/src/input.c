@@ -0,0 +1,205 @@
+#include "input.h"
+
+#define QUEUE_MASK (INPUT_QUEUE_SIZE - 1U)
+
+/* Stan klawiszy, modyfikowany tylko w przerwaniu SysTick */
+static uint8_t stable = 0U;
+static uint8_t counter[INPUT_KEYS];
+static uint32_t changeMs[INPUT_KEYS];
+static uint32_t pressMs[INPUT_KEYS];
+static uint32_t nextRepeatMs[INPUT_KEYS];
+static uint8_t longSent = 0U;
+
+/*
+ * Kolejka jeden producent (SysTick) - jeden konsument (pętla główna).
+ * head zapisuje tylko producent, tail tylko konsument, więc nie trzeba
+ * blokować przerwań. Pełna kolejka odrzuca nowe zdarzenia.
+ */
+static volatile InputEvent_t queue[INPUT_QUEUE_SIZE];
+static volatile uint8_t head = 0U;
+static volatile uint8_t tail = 0U;
+
+static InputStats_t stats;
+
+/*!
+ *  @brief    Wstawia zdarzenie do kolejki, wywoływana z przerwania.
+ *
+ *  @side effects:
+ *            Przy pełnej kolejce zwiększa licznik odrzuconych zdarzeń.
+ */
+static void push(uint8_t type, uint8_t key, int16_t value, uint32_t stampMs)
+{
+    uint8_t h = head;
+    uint8_t next = (uint8_t)((h + 1U) & QUEUE_MASK);
+
+    if (next == tail) {
+        stats.dropped++;
+        return;
+    }
+    queue[h].type = type;
+    queue[h].key = key;
+    queue[h].value = value;
+    queue[h].stampMs = stampMs;
+    head = next;
+}
+
+/*!
+ *  @brief    Inicjalizuje warstwę wejścia.
+ *
+ *  @side effects:
+ *            Czyści stan klawiszy, kolejkę i statystyki.
+ */
+void input_init(void)
+{
+    uint8_t k;
+
+    stable = 0U;
+    longSent = 0U;
+    for (k = 0U; k < INPUT_KEYS; k++) {
+        counter[k] = 0U;
+        changeMs[k] = 0U;
+        pressMs[k] = 0U;
+        nextRepeatMs[k] = 0U;
+    }
+    head = 0U;
+    tail = 0U;
+    stats.events = 0U;
+    stats.dropped = 0U;
+    stats.lastLatencyMs = 0U;
+    stats.maxLatencyMs = 0U;
+}
+
+/*!
+ *  @brief    Próbkuje wejścia, wywoływana co 1 ms z SysTick_Handler.
+ *  @param nowMs
+ *            Aktualny czas w milisekundach
+ *  @param keys
+ *            Surowy stan klawiszy (bity INPUT_KEY_x, 1 = wciśnięty)
+ *  @param encDelta
+ *            Zatrzaski enkodera od poprzedniego wywołania
+ *
+ *  @returns  true jeśli w kolejce czekają zdarzenia
+ *  @side effects:
+ *            Klawisz zmienia stan po INPUT_DEBOUNCE_MS kolejnych zgodnych próbkach.
+ *            Wstawia do kolejki zdarzenia wciśnięcia, puszczenia, powtórzenia,
+ *            długiego przytrzymania i obrotu enkodera.
+ */
+bool input_sample(uint32_t nowMs, uint8_t keys, int32_t encDelta)
+{
+    uint8_t k;
+    uint8_t bit;
+
+    for (k = 0U; k < INPUT_KEYS; k++) {
+        bit = (uint8_t)(1U << k);
+
+        if ((keys & bit) == (stable & bit)) {
+            counter[k] = 0U;
+        }
+        else {
+            if (counter[k] == 0U) {
+                changeMs[k] = nowMs;
+            }
+            counter[k]++;
+            if (counter[k] >= INPUT_DEBOUNCE_MS) {
+                counter[k] = 0U;
+                stable ^= bit;
+                if ((stable & bit) != 0U) {
+                    pressMs[k] = nowMs;
+                    nextRepeatMs[k] = nowMs + INPUT_REPEAT_DELAY_MS;
+                    longSent &= (uint8_t)~bit;
+                    push(INPUT_EV_PRESS, bit, 0, changeMs[k]);
+                }
+                else {
+                    push(INPUT_EV_RELEASE, bit, 0, changeMs[k]);
+                }
+            }
+        }
+
+        /* autopowtarzanie i długie przytrzymanie */
+        if ((stable & bit) != 0U) {
+            if ((bit & INPUT_REPEAT_MASK) != 0U) {
+                if ((int32_t)(nowMs - nextRepeatMs[k]) >= 0) {
+                    nextRepeatMs[k] = nowMs + INPUT_REPEAT_MS;
+                    push(INPUT_EV_REPEAT, bit, 0, nowMs);
+                }
+            }
+            else if (((longSent & bit) == 0U) && ((nowMs - pressMs[k]) >= INPUT_LONG_MS)) {
+                longSent |= bit;
+                push(INPUT_EV_LONG, bit, 0, nowMs);
+            }
+            else {
+                /* długie przytrzymanie już zgłoszone */
+            }
+        }
+    }
+
+    if (encDelta != 0) {
+        if (encDelta > 32767) {
+            encDelta = 32767;
+        }
+        else if (encDelta < -32768) {
+            encDelta = -32768;
+        }
+        else {
+            /* mieści się w int16_t */
+        }
+        push(INPUT_EV_ROTATE, 0U, (int16_t)encDelta, nowMs);
+    }
+    return head != tail;
+}
+
+/*!
+ *  @brief    Pobiera najstarsze zdarzenie z kolejki, bez blokowania.
+ *  @param ev
+ *            Miejsce na zdarzenie
+ *
+ *  @returns  true jeśli zdarzenie zostało pobrane
+ *  @side effects:
+ *            Zwalnia miejsce w kolejce.
+ */
+bool input_get(InputEvent_t* ev)
+{
+    uint8_t t = tail;
+
+    if (t == head) {
+        return false;
+    }
+    ev->type = queue[t].type;
+    ev->key = queue[t].key;
+    ev->value = queue[t].value;
+    ev->stampMs = queue[t].stampMs;
+    tail = (uint8_t)((t + 1U) & QUEUE_MASK);
+    return true;
+}
+
+/*!
+ *  @brief    Zapisuje opóźnienie obsługi zdarzenia.
+ *  @param ev
+ *            Obsłużone zdarzenie
+ *  @param nowMs
+ *            Czas zakończenia obsługi
+ *
+ *  @side effects:
+ *            Opóźnienie liczone jest od pierwszej zmiany stanu wejścia, więc
+ *            obejmuje czas eliminacji drgań styków.
+ */
+void input_dispatched(const InputEvent_t* ev, uint32_t nowMs)
+{
+    stats.events++;
+    stats.lastLatencyMs = nowMs - ev->stampMs;
+    if (stats.lastLatencyMs > stats.maxLatencyMs) {
+        stats.maxLatencyMs = stats.lastLatencyMs;
+    }
+}
+
+/*!
+ *  @brief    Zwraca statystyki warstwy wejścia.
+ *
+ *  @returns  Wskaźnik na statystyki
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+const InputStats_t* input_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,57 @@
+#ifndef __INPUT_H
+#define __INPUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Bity klawiszy - joystick zgodnie z joystick_read(), przycisk zasilania osobno */
+#define INPUT_KEY_CENTER 0x01U
+#define INPUT_KEY_UP     0x02U
+#define INPUT_KEY_DOWN   0x04U
+#define INPUT_KEY_LEFT   0x08U
+#define INPUT_KEY_RIGHT  0x10U
+#define INPUT_KEY_POWER  0x20U
+#define INPUT_KEYS       6U
+
+/* Czasy w milisekundach (próbkowanie co 1 ms z SysTick) */
+#define INPUT_DEBOUNCE_MS     10U
+#define INPUT_REPEAT_DELAY_MS 400U
+#define INPUT_REPEAT_MS       120U
+#define INPUT_LONG_MS         800U
+
+/* Klawisze z autopowtarzaniem; pozostałe zgłaszają jedno długie przytrzymanie */
+#define INPUT_REPEAT_MASK (INPUT_KEY_UP | INPUT_KEY_DOWN | INPUT_KEY_LEFT | INPUT_KEY_RIGHT)
+
+/* Rozmiar kolejki zdarzeń, potęga dwójki */
+#define INPUT_QUEUE_SIZE 16U
+
+typedef enum {
+    INPUT_EV_PRESS,
+    INPUT_EV_RELEASE,
+    INPUT_EV_REPEAT,
+    INPUT_EV_LONG,
+    INPUT_EV_ROTATE
+} InputEventType;
+
+typedef struct {
+    uint8_t type;       /* InputEventType */
+    uint8_t key;        /* bit klawisza, 0 dla enkodera */
+    int16_t value;      /* liczba zatrzasków dla INPUT_EV_ROTATE */
+    uint32_t stampMs;   /* chwila pierwszej zmiany stanu wejścia */
+} InputEvent_t;
+
+/* Statystyki do odczytu debuggerem */
+typedef struct {
+    uint32_t events;
+    uint32_t dropped;
+    uint32_t lastLatencyMs;
+    uint32_t maxLatencyMs;
+} InputStats_t;
+
+void input_init(void);
+bool input_sample(uint32_t nowMs, uint8_t keys, int32_t encDelta);
+bool input_get(InputEvent_t* ev);
+void input_dispatched(const InputEvent_t* ev, uint32_t nowMs);
+const InputStats_t* input_stats(void);
+
+#endif /* __INPUT_H */
@@ -0,0 +1,1205 @@
+#include <string.h>
+
+#include "library.h"
+
+/* Nagłówek indeksu: "WIDX", wersja, rozmiar rekordu, liczba utworów, sygnatura katalogu */
+#define HDR_MAGIC0 'W'
+#define HDR_MAGIC1 'I'
+#define HDR_MAGIC2 'D'
+#define HDR_MAGIC3 'X'
+#define HDR_VERSION 1U
+#define HDR_OFS_VERSION 4U
+#define HDR_OFS_RECSIZE 6U
+#define HDR_OFS_COUNT 8U
+#define HDR_OFS_SIG 12U
+
+/* Układ rekordu */
+#define REC_OFS_NAME 0U
+#define REC_OFS_CLUSTER 13U
+#define REC_OFS_OFFSET 17U
+#define REC_OFS_LENGTH 21U
+#define REC_OFS_RATE 25U
+#define REC_OFS_CHANNELS 27U
+#define REC_OFS_BITS 28U
+#define REC_OFS_GAIN 29U
+#define REC_OFS_FLAGS 30U
+
+#define SIG_BASIS 2166136261UL
+#define SIG_PRIME 16777619UL
+
+typedef enum {
+    LIB_IDLE = 0,
+    LIB_VERIFY,     /* przejście katalogu i porównanie sygnatury */
+    LIB_BUILD,      /* przejście katalogu i zapis rekordów */
+    LIB_COUNT       /* przejście katalogu bez zapisu, gdy indeksu nie da się utworzyć */
+} LibState;
+
+static uint32_t (*getUs)(void) = 0;
+
+static FIL idx;                 /* plik indeksu, otwarty do odczytu gdy valid */
+static FIL titles;              /* plik nazw wyświetlanych, otwarty razem z indeksem */
+static FIL probe;               /* sprawdzanie nagłówków w trakcie budowy */
+static DIR dir;
+static FILINFO info;
+static char lfnBuf[_MAX_LFN + 1];   /* długa nazwa z f_readdir() w stronie kodowej OEM */
+static bool valid = false;
+static bool changed = false;
+static int32_t count = 0;
+static uint32_t sig = 0U;       /* sygnatura zapisana w indeksie */
+static uint32_t walkSig = 0U;   /* sygnatura liczona w trakcie przejścia */
+static int32_t walkCount = 0;
+static LibState state = LIB_IDLE;
+
+/* Lista tylko do odczytu: wpisy czytane wprost z katalogu, bez indeksu */
+static bool direct = false;
+static DIR scan;
+static FILINFO scanInfo;
+static char scanLfn[_MAX_LFN + 1];
+static int32_t scanNext = -1;   /* wpis zwracany przez następny f_readdir(&scan), -1 - od początku */
+
+/* Bieżący katalog: "" dla głównego, inaczej "/KAT1/KAT2" w nazwach 8.3 */
+static char curPath[LIB_PATH_LEN + 1U];
+static uint8_t depth = 0U;
+static char pathBuf[LIB_PATH_LEN + LIB_NAME_LEN + 1U];
+
+/* Pozycja zaznaczenia i liczba wpisów odwiedzonych katalogów, po skrócie ścieżki */
+typedef struct {
+    uint32_t pathHash;          /* 0 - wolne miejsce */
+    int32_t pos;
+    int32_t count;
+} LibDirPos_t;
+
+static LibDirPos_t dirCache[LIB_DIR_CACHE];
+static uint8_t dirNext = 0U;    /* następne miejsce do nadpisania */
+
+/* Okno nazw: LIB_PAGE_ENTRIES kolejnych utworów od pageFirst, pageFirst < 0 gdy puste */
+static char pageNames[LIB_PAGE_ENTRIES][LIB_TITLE_LEN];
+static int32_t pageFirst = -1;
+static int32_t pageLen = 0;
+
+static LibStats_t stats;
+
+/* Znaki CP858 0x80-0xFF sprowadzone do ASCII czcionki ekranu */
+static const char titleFold[] =
+    "CueaaaaceeeiiiAAEeEooouuyOU?????aiounNao???11????????AAA????????"
+    "??????aA??????????EEE?III?????I?OsOOoO???UUUyY?????3???????132? ";
+
+/*!
+ *  @brief    Odczyt liczb little-endian z bufora.
+ *
+ *  @returns  Wartość 16- albo 32-bitowa
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static uint16_t get16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*!
+ *  @brief    Zapis liczb little-endian do bufora.
+ *
+ *  @side effects:
+ *            Zapisuje 2 albo 4 bajty pod p
+ */
+static void put16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/*!
+ *  @brief    Sprawdza czy nazwa ma rozszerzenie .WAV.
+ *
+ *  @returns  true dla plików WAV
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static bool is_wav(const char* name)
+{
+    const char* ext = strrchr(name, '.');
+
+    return (ext != NULL) && ((strcmp(ext, ".WAV") == 0) || (strcmp(ext, ".wav") == 0));
+}
+
+/*!
+ *  @brief    Składa ścieżkę pliku w bieżącym katalogu.
+ *  @param name
+ *            Nazwa 8.3
+ *
+ *  @returns  Ścieżka w pathBuf, ważna do następnego wywołania
+ *  @side effects:
+ *            Nadpisuje pathBuf
+ */
+static const char* path_join(const char* name)
+{
+    uint32_t len = strlen(curPath);
+
+    (void)memcpy(pathBuf, curPath, len);
+    pathBuf[len] = '/';
+    (void)strncpy(&pathBuf[len + 1U], name, LIB_NAME_LEN);
+    pathBuf[len + LIB_NAME_LEN] = '\0';
+    return pathBuf;
+}
+
+/*!
+ *  @brief    Skrót ścieżki bieżącego katalogu do pamięci pozycji.
+ *
+ *  @returns  FNV-1a ścieżki, nigdy 0
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static uint32_t path_hash(void)
+{
+    const char* p = curPath;
+    uint32_t h = SIG_BASIS;
+
+    while (*p != '\0') {
+        h = (h ^ (uint8_t)*p) * SIG_PRIME;
+        p++;
+    }
+    return (h != 0U) ? h : 1U;
+}
+
+/*!
+ *  @brief    Szuka zapamiętanej pozycji bieżącego katalogu.
+ *
+ *  @returns  Wpis pamięci albo NULL
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static LibDirPos_t* dirpos_find(uint32_t hash)
+{
+    uint32_t i;
+
+    for (i = 0U; i < LIB_DIR_CACHE; i++) {
+        if (dirCache[i].pathHash == hash) {
+            return &dirCache[i];
+        }
+    }
+    return NULL;
+}
+
+/*!
+ *  @brief    Zapamiętuje pozycję zaznaczenia i liczbę wpisów bieżącego katalogu.
+ *
+ *  @side effects:
+ *            Nowy katalog zajmuje najstarsze miejsce pamięci.
+ */
+static void dirpos_store(int32_t pos)
+{
+    uint32_t hash = path_hash();
+    LibDirPos_t* d = dirpos_find(hash);
+
+    if (d == NULL) {
+        d = &dirCache[dirNext];
+        dirNext = (uint8_t)((dirNext + 1U) % LIB_DIR_CACHE);
+    }
+    d->pathHash = hash;
+    d->pos = pos;
+    d->count = count;
+}
+
+/*!
+ *  @brief    Dolicza wpis katalogu do sygnatury (nazwa, rozmiar, data i czas zmiany).
+ *
+ *  @side effects:
+ *            Zmienia walkSig. Plik indeksu jest pomijany.
+ */
+static void sig_add(const FILINFO* fi)
+{
+    const char* p = fi->fname;
+    uint8_t b[8];
+    uint32_t i;
+
+    if ((strcmp(fi->fname, LIB_INDEX_NAME) == 0) || (strcmp(fi->fname, LIB_TITLES_NAME) == 0)) {
+        return;
+    }
+    while (*p != '\0') {
+        walkSig = (walkSig ^ (uint8_t)*p) * SIG_PRIME;
+        p++;
+    }
+    /* zmiana samej długiej nazwy też wymaga nowego pliku nazw */
+    p = fi->lfname;
+    while (*p != '\0') {
+        walkSig = (walkSig ^ (uint8_t)*p) * SIG_PRIME;
+        p++;
+    }
+    put32(&b[0], fi->fsize);
+    put16(&b[4], fi->fdate);
+    put16(&b[6], fi->ftime);
+    b[0] ^= fi->fattrib;
+    for (i = 0U; i < sizeof(b); i++) {
+        walkSig = (walkSig ^ b[i]) * SIG_PRIME;
+    }
+}
+
+/*!
+ *  @brief    Czyta i dekoduje nagłówek WAV z otwartego pliku.
+ *  @param fp
+ *            Plik ustawiony na początku
+ *  @param t
+ *            Rekord uzupełniany o format i rozmiar danych
+ *
+ *  @returns  true jeśli nagłówek jest nagłówkiem RIFF
+ *  @side effects:
+ *            Przesuwa wskaźnik pliku na początek danych.
+ */
+static bool wav_header(FIL* fp, LibTrack_t* t)
+{
+    UINT br;
+    uint8_t hdr[WAV_HEADER_SIZE];
+
+    if ((f_read(fp, hdr, WAV_HEADER_SIZE, &br) != FR_OK) || (br != WAV_HEADER_SIZE)) {
+        return false;
+    }
+    t->channels = (uint8_t)get16(&hdr[22]);
+    t->sampleRate = (uint16_t)get32(&hdr[24]);
+    t->bits = (uint8_t)get16(&hdr[34]);
+    t->length = get32(&hdr[40]);
+    t->dataOffset = WAV_HEADER_SIZE;
+    return (hdr[0] == WAV_RIFF_SIGNATURE) && (hdr[1] == WAV_RIFF_SIGNATURE2);
+}
+
+/*!
+ *  @brief    Sprawdza czy wpis katalogu trafia do listy.
+ *
+ *  @returns  true dla plików WAV i podkatalogów
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static bool is_listed(const FILINFO* fi)
+{
+    if ((fi->fattrib & (AM_HID | AM_SYS)) != 0U) {
+        return false;
+    }
+    return ((fi->fattrib & AM_DIR) != 0U) || is_wav(fi->fname);
+}
+
+/*!
+ *  @brief    Przerywa trwające sprawdzanie albo budowę indeksu.
+ *
+ *  @side effects:
+ *            Niedokończony indeks ma zerowy nagłówek i zostanie zbudowany
+ *            ponownie przy następnym wejściu do katalogu.
+ */
+static void walk_abort(void)
+{
+    if (state == LIB_BUILD) {
+        (void)f_close(&idx);
+        (void)f_close(&titles);
+    }
+    state = LIB_IDLE;
+}
+
+/*!
+ *  @brief    Zamyka pliki indeksu i nazw.
+ *
+ *  @side effects:
+ *            Indeks i lista tylko do odczytu przestają być ważne, okno nazw
+ *            jest opróżniane.
+ */
+static void lib_close(void)
+{
+    if (valid == true) {
+        (void)f_close(&idx);
+        (void)f_close(&titles);
+        valid = false;
+    }
+    direct = false;
+    scanNext = -1;
+    count = 0;
+    pageFirst = -1;
+    pageLen = 0;
+}
+
+/*!
+ *  @brief    Tworzy nazwę wyświetlaną: długą nazwę, a gdy jej brak nazwę 8.3.
+ *  @param rec
+ *            Rekord pliku nazw, LIB_TITLE_REC bajtów
+ *  @param fi
+ *            Wpis katalogu z f_readdir()
+ *
+ *  @side effects:
+ *            Znaki spoza ASCII są zamieniane według titleFold.
+ */
+static void title_make(uint8_t* rec, const FILINFO* fi)
+{
+    const char* src = (fi->lfname[0] != '\0') ? fi->lfname : fi->fname;
+    uint32_t i;
+    uint8_t c;
+
+    (void)memset(rec, 0, LIB_TITLE_REC);
+    for (i = 0U; (i < (LIB_TITLE_REC - 1U)) && (src[i] != '\0'); i++) {
+        c = (uint8_t)src[i];
+        rec[i] = (c >= 0x80U) ? (uint8_t)titleFold[c - 0x80U] : c;
+    }
+    /* katalogi z ukośnikiem na końcu, widocznym także w skróconej nazwie */
+    if (((fi->fattrib & AM_DIR) != 0U) && (strcmp(src, "..") != 0)) {
+        if (i > (LIB_TITLE_LEN - 2U)) {
+            i = LIB_TITLE_LEN - 2U;
+        }
+        rec[i] = '/';
+        rec[i + 1U] = '\0';
+    }
+}
+
+/*!
+ *  @brief    Tworzy rekord wpisu katalogu.
+ *  @param fi
+ *            Wpis katalogu: plik WAV, podkatalog albo ".."
+ *  @param t
+ *            Rekord do wypełnienia
+ *
+ *  @returns  false gdy pliku nie da się otworzyć
+ *  @side effects:
+ *            Dla pliku WAV otwiera go i czyta nagłówek. Podkatalogi i ".."
+ *            dostają rekord bez formatu z LIB_FLAG_x.
+ */
+static bool track_make(const FILINFO* fi, LibTrack_t* t)
+{
+    (void)memset(t, 0, sizeof(*t));
+    (void)strncpy(t->name, fi->fname, LIB_NAME_LEN - 1U);
+    if ((fi->fattrib & AM_DIR) != 0U) {
+        t->flags = (strcmp(fi->fname, "..") == 0) ? (LIB_FLAG_DIR | LIB_FLAG_PARENT) : LIB_FLAG_DIR;
+        return true;
+    }
+    if (f_open(&probe, path_join(fi->fname), FA_READ) != FR_OK) {
+        stats.errors++;
+        return false;
+    }
+    if (wav_header(&probe, t) == false) {
+        /* nie-RIFF: rekord bez formatu, odtwarzanie pokaże błąd formatu */
+        t->length = 0U;
+    }
+    t->startCluster = probe.org_clust;
+    (void)f_close(&probe);
+    return true;
+}
+
+/*!
+ *  @brief    Przechodzi na listę tylko do odczytu, gdy indeksu nie da się zapisać.
+ *
+ *  @side effects:
+ *            Pliki indeksu muszą być zamknięte. Zaczyna od nowa przejście
+ *            katalogu, które tylko liczy wpisy (lib_step()); potem lib_get()
+ *            i lib_name() czytają je wprost z katalogu.
+ */
+static void direct_start(void)
+{
+    stats.errors++;
+    stats.directLists++;
+    state = LIB_IDLE;
+    if (f_opendir(&dir, (depth > 0U) ? curPath : "/") != FR_OK) {
+        return;
+    }
+    walkSig = SIG_BASIS;
+    walkCount = (depth > 0U) ? 1 : 0;   /* ".." */
+    state = LIB_COUNT;
+}
+
+/*!
+ *  @brief    Kończy liczenie wpisów listy tylko do odczytu.
+ *
+ *  @side effects:
+ *            Lista staje się dostępna i zgłaszana jest jej zmiana. Sygnatura
+ *            pozwala lib_verify() ponowić budowę indeksu po zmianie na karcie.
+ */
+static void direct_finish(void)
+{
+    state = LIB_IDLE;
+    lib_close();
+    count = walkCount;
+    sig = walkSig;
+    direct = true;
+    changed = true;
+}
+
+/*!
+ *  @brief    Czyta wpis listy tylko do odczytu wprost z katalogu.
+ *  @param index
+ *            Numer wpisu
+ *  @param out
+ *            Rekord wpisu albo NULL
+ *  @param title
+ *            Bufor LIB_TITLE_LEN bajtów na nazwę wyświetlaną albo NULL
+ *
+ *  @returns  false poza katalogiem albo przy błędzie odczytu
+ *  @side effects:
+ *            Kolejne numery czytane są dalej od bieżącej pozycji w katalogu,
+ *            dopiero cofnięcie zaczyna przejście od początku. Rekord pliku WAV
+ *            wymaga otwarcia go i odczytu nagłówka.
+ */
+static bool direct_get(int32_t index, LibTrack_t* out, char* title)
+{
+    uint8_t rec[LIB_TITLE_REC];
+    int32_t n = index - ((depth > 0U) ? 1 : 0);
+
+    if (n < 0) {
+        /* ".." nie pochodzi z f_readdir() */
+        (void)strcpy(scanInfo.fname, "..");
+        scanInfo.fattrib = AM_DIR;
+        scanLfn[0] = '\0';
+    }
+    else {
+        if ((scanNext < 0) || (n < scanNext)) {
+            if (f_opendir(&scan, (depth > 0U) ? curPath : "/") != FR_OK) {
+                stats.errors++;
+                return false;
+            }
+            scanNext = 0;
+        }
+        while (scanNext <= n) {
+            if ((f_readdir(&scan, &scanInfo) != FR_OK) || (scanInfo.fname[0] == 0)) {
+                scanNext = -1;
+                return false;
+            }
+            if (is_listed(&scanInfo) == true) {
+                scanNext++;
+            }
+        }
+    }
+
+    if ((out != NULL) && (track_make(&scanInfo, out) == false)) {
+        return false;
+    }
+    if (title != NULL) {
+        title_make(rec, &scanInfo);
+        (void)memcpy(title, rec, LIB_TITLE_LEN - 1U);
+        title[LIB_TITLE_LEN - 1U] = '\0';
+        stats.pageReads++;
+    }
+    return true;
+}
+
+/*!
+ *  @brief    Czyta nazwę wyświetlaną utworu z pliku nazw.
+ *  @param index
+ *            Numer utworu
+ *  @param dst
+ *            Bufor LIB_TITLE_LEN bajtów
+ *
+ *  @returns  false przy błędzie odczytu
+ *  @side effects:
+ *            Kolejne rekordy z tego samego sektora pochodzą z okna systemu plików.
+ *            Lista tylko do odczytu bierze nazwę wprost z katalogu.
+ */
+static bool title_read(int32_t index, char* dst)
+{
+    UINT br;
+
+    if (direct == true) {
+        return direct_get(index, NULL, dst);
+    }
+    if ((f_lseek(&titles, LIB_TITLE_REC * (uint32_t)index) != FR_OK)
+        || (f_read(&titles, dst, LIB_TITLE_LEN, &br) != FR_OK) || (br != LIB_TITLE_LEN)) {
+        stats.errors++;
+        return false;
+    }
+    dst[LIB_TITLE_LEN - 1U] = '\0';
+    stats.pageReads++;
+    return true;
+}
+
+/*!
+ *  @brief    Kończy budowę: zapisuje nagłówek i otwiera indeks do odczytu.
+ *
+ *  @side effects:
+ *            Przy sukcesie indeks staje się ważny i zgłaszana jest zmiana listy,
+ *            przy błędzie zaczyna się lista tylko do odczytu.
+ */
+static void build_finish(void)
+{
+    uint8_t hdr[LIB_REC_SIZE];
+    UINT bw;
+    FRESULT fr;
+
+    (void)memset(hdr, 0, sizeof(hdr));
+    hdr[0] = HDR_MAGIC0;
+    hdr[1] = HDR_MAGIC1;
+    hdr[2] = HDR_MAGIC2;
+    hdr[3] = HDR_MAGIC3;
+    put16(&hdr[HDR_OFS_VERSION], HDR_VERSION);
+    put16(&hdr[HDR_OFS_RECSIZE], LIB_REC_SIZE);
+    put32(&hdr[HDR_OFS_COUNT], (uint32_t)walkCount);
+    put32(&hdr[HDR_OFS_SIG], walkSig);
+
+    fr = f_lseek(&idx, 0U);
+    if (fr == FR_OK) {
+        fr = f_write(&idx, hdr, LIB_REC_SIZE, &bw);
+    }
+    if (f_close(&idx) != FR_OK) {
+        fr = FR_DISK_ERR;
+    }
+    if (f_close(&titles) != FR_OK) {
+        fr = FR_DISK_ERR;
+    }
+    state = LIB_IDLE;
+    if ((fr != FR_OK) || (lib_load() == false)) {
+        direct_start();
+        return;
+    }
+    changed = true;
+}
+
+/*!
+ *  @brief    Dopisuje rekord wpisu do indeksu i jego nazwę do pliku nazw.
+ *  @param fi
+ *            Wpis katalogu: plik WAV, podkatalog albo ".."
+ *
+ *  @side effects:
+ *            Przy błędzie zapisu porzuca indeks i przechodzi na listę
+ *            tylko do odczytu.
+ */
+static void build_record(const FILINFO* fi)
+{
+    LibTrack_t t;
+    uint8_t rec[LIB_REC_SIZE];
+    uint8_t title[LIB_TITLE_REC];
+    UINT bw;
+
+    if (track_make(fi, &t) == false) {
+        return;
+    }
+
+    (void)memset(rec, 0, sizeof(rec));
+    (void)memcpy(&rec[REC_OFS_NAME], t.name, LIB_NAME_LEN);
+    put32(&rec[REC_OFS_CLUSTER], t.startCluster);
+    put32(&rec[REC_OFS_OFFSET], t.dataOffset);
+    put32(&rec[REC_OFS_LENGTH], t.length);
+    put16(&rec[REC_OFS_RATE], t.sampleRate);
+    rec[REC_OFS_CHANNELS] = t.channels;
+    rec[REC_OFS_BITS] = t.bits;
+    rec[REC_OFS_GAIN] = (uint8_t)t.gainDb;
+    rec[REC_OFS_FLAGS] = t.flags;
+    title_make(title, fi);
+
+    /* pełna karta albo błąd zapisu - lista bez indeksu */
+    if ((f_write(&titles, title, LIB_TITLE_REC, &bw) != FR_OK) || (bw != LIB_TITLE_REC)
+        || (f_write(&idx, rec, LIB_REC_SIZE, &bw) != FR_OK) || (bw != LIB_REC_SIZE)) {
+        (void)f_close(&idx);
+        (void)f_close(&titles);
+        direct_start();
+        return;
+    }
+    walkCount++;
+}
+
+/*!
+ *  @brief    Jeden wpis katalogu w trakcie budowy indeksu.
+ *
+ *  @side effects:
+ *            Dla pliku WAV otwiera go, czyta nagłówek i dopisuje rekord do indeksu
+ *            oraz nazwę wyświetlaną do pliku nazw - długie nazwy są składane
+ *            z wpisów katalogu tylko tutaj, raz na zmianę zawartości karty.
+ */
+static void build_entry(void)
+{
+    sig_add(&info);
+    if (is_listed(&info) == false) {
+        return;
+    }
+    build_record(&info);
+}
+
+/*!
+ *  @brief    Inicjalizuje bibliotekę utworów.
+ *  @param clockUs
+ *            Funkcja zwracająca czas w mikrosekundach, używana do statystyk
+ *
+ *  @side effects:
+ *            Zeruje stan i statystyki; system plików musi być zamontowany
+ *            przed lib_load().
+ */
+void lib_init(uint32_t (*clockUs)(void))
+{
+    getUs = clockUs;
+    valid = false;
+    changed = false;
+    count = 0;
+    state = LIB_IDLE;
+    info.lfname = lfnBuf;
+    info.lfsize = (int)sizeof(lfnBuf);
+    scanInfo.lfname = scanLfn;
+    scanInfo.lfsize = (int)sizeof(scanLfn);
+    direct = false;
+    scanNext = -1;
+    curPath[0] = '\0';
+    depth = 0U;
+    dirNext = 0U;
+    (void)memset(dirCache, 0, sizeof(dirCache));
+    (void)memset(&stats, 0, sizeof(stats));
+}
+
+/*!
+ *  @brief    Otwiera indeks i plik nazw z karty i sprawdza nagłówek indeksu.
+ *
+ *  @returns  true jeśli oba pliki istnieją i są zgodne
+ *  @side effects:
+ *            Jeden odczyt sektora; rekordy i nazwy są czytane na żądanie
+ *            przez lib_get() i lib_name().
+ */
+bool lib_load(void)
+{
+    uint8_t hdr[LIB_REC_SIZE];
+    UINT br;
+    uint32_t start = getUs();
+
+    lib_close();
+    stats.loads++;
+    if (f_open(&idx, path_join(LIB_INDEX_NAME), FA_READ) != FR_OK) {
+        return false;
+    }
+    if ((f_read(&idx, hdr, LIB_REC_SIZE, &br) != FR_OK) || (br != LIB_REC_SIZE)
+        || (hdr[0] != HDR_MAGIC0) || (hdr[1] != HDR_MAGIC1) || (hdr[2] != HDR_MAGIC2) || (hdr[3] != HDR_MAGIC3)
+        || (get16(&hdr[HDR_OFS_VERSION]) != HDR_VERSION) || (get16(&hdr[HDR_OFS_RECSIZE]) != LIB_REC_SIZE)
+        || (idx.fsize != (LIB_REC_SIZE * (get32(&hdr[HDR_OFS_COUNT]) + 1U)))) {
+        (void)f_close(&idx);
+        return false;
+    }
+    count = (int32_t)get32(&hdr[HDR_OFS_COUNT]);
+    sig = get32(&hdr[HDR_OFS_SIG]);
+    if (f_open(&titles, path_join(LIB_TITLES_NAME), FA_READ) != FR_OK) {
+        (void)f_close(&idx);
+        count = 0;
+        return false;
+    }
+    if (titles.fsize != (LIB_TITLE_REC * (uint32_t)count)) {
+        (void)f_close(&titles);
+        (void)f_close(&idx);
+        count = 0;
+        return false;
+    }
+    valid = true;
+    stats.loadUs = getUs() - start;
+    return true;
+}
+
+/*!
+ *  @brief    Zaczyna sprawdzanie w tle, czy katalog zmienił się od budowy indeksu.
+ *
+ *  @side effects:
+ *            Przejście katalogu wykonują kolejne wywołania lib_step(); przy
+ *            różnej sygnaturze indeks jest budowany od nowa.
+ */
+void lib_verify(void)
+{
+    if (state != LIB_IDLE) {
+        return;
+    }
+    if (f_opendir(&dir, (depth > 0U) ? curPath : "/") != FR_OK) {
+        stats.errors++;
+        return;
+    }
+    walkSig = SIG_BASIS;
+    stats.verifies++;
+    state = LIB_VERIFY;
+}
+
+/*!
+ *  @brief    Zaczyna budowę indeksu od nowa.
+ *
+ *  @side effects:
+ *            Zamyka dotychczasowy indeks (lib_get() zwraca false do końca budowy)
+ *            i tworzy go z pustym nagłówkiem razem z pustym plikiem nazw;
+ *            wpisy dopisują kolejne lib_step(). Gdy plików nie da się zapisać,
+ *            kolejne kroki budują listę tylko do odczytu.
+ */
+void lib_rebuild(void)
+{
+    uint8_t hdr[LIB_REC_SIZE];
+    UINT bw;
+
+    lib_close();
+    state = LIB_IDLE;
+    if (f_opendir(&dir, (depth > 0U) ? curPath : "/") != FR_OK) {
+        stats.errors++;
+        return;
+    }
+
+    /* pełna karta, pełny katalog główny FAT12/16 albo błąd zapisu - lista bez indeksu */
+    if (f_open(&idx, path_join(LIB_INDEX_NAME), FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        direct_start();
+        return;
+    }
+    if (f_open(&titles, path_join(LIB_TITLES_NAME), FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        (void)f_close(&idx);
+        direct_start();
+        return;
+    }
+    /* nagłówek z zerową liczbą utworów - nieważny do końca budowy */
+    (void)memset(hdr, 0, sizeof(hdr));
+    if ((f_write(&idx, hdr, LIB_REC_SIZE, &bw) != FR_OK) || (bw != LIB_REC_SIZE)) {
+        (void)f_close(&idx);
+        (void)f_close(&titles);
+        direct_start();
+        return;
+    }
+    walkSig = SIG_BASIS;
+    walkCount = 0;
+    stats.rebuilds++;
+    state = LIB_BUILD;
+
+    /* f_readdir() bez _FS_RPATH pomija "." i "..", powrót jest pierwszym rekordem */
+    if (depth > 0U) {
+        (void)strcpy(info.fname, "..");
+        info.fattrib = AM_DIR;
+        lfnBuf[0] = '\0';
+        build_record(&info);
+    }
+}
+
+/*!
+ *  @brief    Jeden krok sprawdzania albo budowy indeksu: jeden wpis katalogu.
+ *
+ *  @returns  true jeśli zostały dalsze kroki
+ *  @side effects:
+ *            Odczyt wpisu katalogu, przy budowie także nagłówka WAV i zapis rekordu.
+ */
+bool lib_step(void)
+{
+    uint32_t start;
+    uint32_t elapsed;
+    FRESULT fr;
+
+    if (state == LIB_IDLE) {
+        return false;
+    }
+    start = getUs();
+
+    fr = f_readdir(&dir, &info);
+    if ((fr != FR_OK) || (info.fname[0] == 0)) {
+        if (state == LIB_BUILD) {
+            build_finish();
+        }
+        else if (state == LIB_COUNT) {
+            direct_finish();
+        }
+        else {
+            state = LIB_IDLE;
+            if ((fr != FR_OK) || (walkSig != sig)) {
+                lib_rebuild();
+            }
+        }
+    }
+    else if (state == LIB_BUILD) {
+        build_entry();
+    }
+    else {
+        sig_add(&info);
+        if ((state == LIB_COUNT) && (is_listed(&info) == true)) {
+            walkCount++;
+        }
+    }
+
+    elapsed = getUs() - start;
+    stats.steps++;
+    if (elapsed > stats.stepMaxUs) {
+        stats.stepMaxUs = elapsed;
+    }
+    return state != LIB_IDLE;
+}
+
+/*!
+ *  @brief    Sprawdza czy trwa sprawdzanie albo budowa indeksu.
+ *
+ *  @returns  true w trakcie pracy w tle
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+bool lib_busy(void)
+{
+    return state != LIB_IDLE;
+}
+
+/*!
+ *  @brief    Zwraca i kasuje znacznik przebudowy indeksu.
+ *
+ *  @returns  true jeśli od ostatniego wywołania zbudowano nowy indeks
+ *  @side effects:
+ *            Kasuje znacznik
+ */
+bool lib_takeChanged(void)
+{
+    bool c = changed;
+
+    changed = false;
+    return c;
+}
+
+/*!
+ *  @brief    Sprawdza czy lista jest czytana wprost z katalogu, bez indeksu.
+ *
+ *  @returns  true gdy indeksu nie dało się zapisać na karcie
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+bool lib_readOnly(void)
+{
+    return direct;
+}
+
+/*!
+ *  @brief    Liczba utworów w indeksie.
+ *
+ *  @returns  Liczba rekordów, 0 gdy indeks nie jest wczytany
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+int32_t lib_count(void)
+{
+    return ((valid == true) || (direct == true)) ? count : 0;
+}
+
+/*!
+ *  @brief    Czyta jeden rekord indeksu.
+ *  @param index
+ *            Numer utworu
+ *  @param out
+ *            Odczytany rekord
+ *
+ *  @returns  false poza zakresem albo przy błędzie odczytu
+ *  @side effects:
+ *            Najwyżej jeden odczyt sektora - kolejne rekordy z tego samego
+ *            sektora pochodzą z okna systemu plików.
+ */
+bool lib_get(int32_t index, LibTrack_t* out)
+{
+    uint8_t rec[LIB_REC_SIZE];
+    UINT br;
+
+    if (((valid == false) && (direct == false)) || (index < 0) || (index >= count)) {
+        return false;
+    }
+    if (direct == true) {
+        return direct_get(index, out, NULL);
+    }
+    if ((f_lseek(&idx, LIB_REC_SIZE * (uint32_t)(index + 1)) != FR_OK)
+        || (f_read(&idx, rec, LIB_REC_SIZE, &br) != FR_OK) || (br != LIB_REC_SIZE)) {
+        stats.errors++;
+        return false;
+    }
+    (void)memcpy(out->name, &rec[REC_OFS_NAME], LIB_NAME_LEN);
+    out->name[LIB_NAME_LEN - 1U] = '\0';
+    out->startCluster = get32(&rec[REC_OFS_CLUSTER]);
+    out->dataOffset = get32(&rec[REC_OFS_OFFSET]);
+    out->length = get32(&rec[REC_OFS_LENGTH]);
+    out->sampleRate = get16(&rec[REC_OFS_RATE]);
+    out->channels = rec[REC_OFS_CHANNELS];
+    out->bits = rec[REC_OFS_BITS];
+    out->gainDb = (int8_t)rec[REC_OFS_GAIN];
+    out->flags = rec[REC_OFS_FLAGS];
+    return true;
+}
+
+/*!
+ *  @brief    Zwraca nazwę wyświetlaną utworu z okna nazw, doczytując brakujące rekordy.
+ *  @param index
+ *            Numer utworu
+ *
+ *  @returns  Długa nazwa (albo 8.3 gdy jej brak) skrócona do LIB_TITLE_LEN - 1
+ *            znaków, ważna do następnego wywołania; NULL poza zakresem
+ *  @side effects:
+ *            Przy chybieniu okno przesuwa się tak, aby objąć index: w przód
+ *            z index na końcu, w tył z index na początku. Wpisy wspólne
+ *            ze starym oknem są przesuwane w RAM, z pliku nazw czytane są tylko
+ *            nowe - przewijanie o jedną pozycję kosztuje jeden rekord.
+ */
+const char* lib_name(int32_t index)
+{
+    int32_t first;
+    int32_t len;
+    int32_t shift;
+    int32_t i;
+
+    if (((valid == false) && (direct == false)) || (index < 0) || (index >= count)) {
+        return NULL;
+    }
+    if ((pageFirst >= 0) && (index >= pageFirst) && (index < (pageFirst + pageLen))) {
+        stats.pageHits++;
+        return pageNames[index - pageFirst];
+    }
+
+    first = (index > pageFirst) ? (index - (int32_t)LIB_PAGE_ENTRIES + 1) : index;
+    if (first < 0) {
+        first = 0;
+    }
+    len = count - first;
+    if (len > (int32_t)LIB_PAGE_ENTRIES) {
+        len = (int32_t)LIB_PAGE_ENTRIES;
+    }
+
+    /* część wspólna ze starym oknem zostaje w RAM */
+    shift = first - pageFirst;
+    if ((pageFirst >= 0) && (shift > 0) && (shift < pageLen)) {
+        (void)memmove(pageNames[0], pageNames[shift], (uint32_t)(pageLen - shift) * LIB_TITLE_LEN);
+        i = pageLen - shift;
+    }
+    else if ((pageFirst >= 0) && (shift < 0) && (-shift < len)) {
+        (void)memmove(pageNames[-shift], pageNames[0], (uint32_t)(len + shift) * LIB_TITLE_LEN);
+        for (i = 0; i < -shift; i++) {
+            if (title_read(first + i, pageNames[i]) == false) {
+                pageFirst = -1;
+                return NULL;
+            }
+        }
+        i = len;
+    }
+    else {
+        i = 0;
+    }
+    for (; i < len; i++) {
+        if (title_read(first + i, pageNames[i]) == false) {
+            pageFirst = -1;
+            return NULL;
+        }
+    }
+    pageFirst = first;
+    pageLen = len;
+    return pageNames[index - first];
+}
+
+/*!
+ *  @brief    Szuka utworu o podanym pierwszym klastrze w pobliżu poprzedniego numeru.
+ *  @param cluster
+ *            Pierwszy klaster pliku (FIL.org_clust)
+ *  @param near
+ *            Numer utworu sprzed zmiany indeksu
+ *
+ *  @returns  Numer utworu albo -1 gdy nie ma go w odległości LIB_PAGE_ENTRIES
+ *  @side effects:
+ *            Najwyżej 2 * LIB_PAGE_ENTRIES + 1 rekordów - ograniczony czas kroku
+ *            niezależnie od liczby utworów.
+ */
+int32_t lib_findCluster(uint32_t cluster, int32_t near)
+{
+    LibTrack_t t;
+    int32_t d;
+
+    for (d = 0; d <= (int32_t)LIB_PAGE_ENTRIES; d++) {
+        if ((lib_get(near + d, &t) == true) && (t.startCluster == cluster)) {
+            return near + d;
+        }
+        if ((d > 0) && (lib_get(near - d, &t) == true) && (t.startCluster == cluster)) {
+            return near - d;
+        }
+    }
+    return -1;
+}
+
+/*!
+ *  @brief    Przechodzi do podkatalogu albo do katalogu nadrzędnego.
+ *  @param entry
+ *            Rekord katalogu z bieżącej listy (LIB_FLAG_DIR, ".." z LIB_FLAG_PARENT)
+ *  @param pos
+ *            Zaznaczenie w opuszczanym katalogu, zapamiętywane na powrót
+ *
+ *  @returns  Zaznaczenie w nowym katalogu, -1 gdy zmiana jest niemożliwa
+ *  @side effects:
+ *            Wczytuje nagłówek indeksu nowego katalogu i zaczyna sprawdzanie
+ *            go w tle; bez indeksu zaczyna budowę (lib_step()). Zapamiętana
+ *            pozycja jest przywracana tylko przy zgodnej liczbie wpisów.
+ */
+int32_t lib_enter(const LibTrack_t* entry, int32_t pos)
+{
+    uint32_t len = strlen(curPath);
+    uint32_t nameLen = strlen(entry->name);
+    LibDirPos_t* d;
+    char* slash;
+
+    if ((entry->flags & LIB_FLAG_DIR) == 0U) {
+        return -1;
+    }
+    if ((entry->flags & LIB_FLAG_PARENT) == 0U) {
+        if ((depth >= LIB_DIR_DEPTH) || ((len + 1U + nameLen) > LIB_PATH_LEN)) {
+            return -1;
+        }
+    }
+    else if (depth == 0U) {
+        return -1;
+    }
+    else {
+        /* w katalogu nadrzędnym */
+    }
+
+    dirpos_store(pos);
+    walk_abort();
+    lib_close();
+    if ((entry->flags & LIB_FLAG_PARENT) == 0U) {
+        curPath[len] = '/';
+        (void)memcpy(&curPath[len + 1U], entry->name, nameLen + 1U);
+        depth++;
+    }
+    else {
+        slash = strrchr(curPath, '/');
+        *slash = '\0';
+        depth--;
+    }
+
+    if (lib_load() == false) {
+        lib_rebuild();
+        stats.dirMisses++;
+        return 0;
+    }
+    lib_verify();
+    d = dirpos_find(path_hash());
+    if ((d == NULL) || (d->count != count) || (d->pos >= count)) {
+        stats.dirMisses++;
+        return 0;
+    }
+    stats.dirHits++;
+    return d->pos;
+}
+
+/*!
+ *  @brief    Szuka w głąb podkatalogu, którego ścieżka ma podany skrót.
+ *  @param hash
+ *            Skrót z lib_pathHash()
+ *
+ *  @returns  true jeśli znaleziono - curPath i depth wskazują katalog
+ *  @side effects:
+ *            Dopisuje kolejne podkatalogi do curPath i cofa je, gdy nie pasują.
+ *            Jeden poziom rekurencji (DIR i FILINFO na stosie) na poziom drzewa,
+ *            najwyżej LIB_DIR_DEPTH.
+ */
+static bool dir_search(uint16_t hash)
+{
+    DIR d;
+    FILINFO fi;
+    uint32_t len = strlen(curPath);
+
+    if (f_opendir(&d, (depth > 0U) ? curPath : "/") != FR_OK) {
+        return false;
+    }
+    fi.lfname = NULL;
+    fi.lfsize = 0;
+    while ((f_readdir(&d, &fi) == FR_OK) && (fi.fname[0] != 0)) {
+        if (((fi.fattrib & AM_DIR) == 0U) || (is_listed(&fi) == false)
+            || ((len + 1U + strlen(fi.fname)) > LIB_PATH_LEN)) {
+            continue;
+        }
+        curPath[len] = '/';
+        (void)strcpy(&curPath[len + 1U], fi.fname);
+        depth++;
+        if ((lib_pathHash() == hash) || ((depth < LIB_DIR_DEPTH) && (dir_search(hash) == true))) {
+            return true;
+        }
+        depth--;
+        curPath[len] = '\0';
+    }
+    return false;
+}
+
+/*!
+ *  @brief    Wchodzi z katalogu głównego do katalogu o podanym skrócie ścieżki.
+ *  @param hash
+ *            Skrót zapisany z lib_pathHash()
+ *
+ *  @returns  true jeśli katalog znaleziono
+ *  @side effects:
+ *            Przeszukuje drzewo katalogów - wywoływana raz przy wznowieniu po
+ *            starcie. Wczytuje indeks znalezionego katalogu, bez indeksu zaczyna
+ *            budowę (lib_step()). Gdy katalogu nie ma, indeks głównego zostaje.
+ */
+bool lib_enterPath(uint16_t hash)
+{
+    if ((hash == 0U) || (depth != 0U)) {
+        return false;
+    }
+    if (dir_search(hash) == false) {
+        curPath[0] = '\0';
+        depth = 0U;
+        return false;
+    }
+    walk_abort();
+    if (lib_load() == false) {
+        lib_rebuild();
+    }
+    return true;
+}
+
+/*!
+ *  @brief    Skrót ścieżki bieżącego katalogu do zapisu stanu w EEPROM.
+ *
+ *  @returns  16-bitowy skrót, 0 dla katalogu głównego
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+uint16_t lib_pathHash(void)
+{
+    uint32_t h;
+
+    if (depth == 0U) {
+        return 0U;
+    }
+    h = path_hash();
+    h = (h ^ (h >> 16)) & 0xFFFFU;
+    return (h != 0U) ? (uint16_t)h : 1U;
+}
+
+/*!
+ *  @brief    Głębokość bieżącego katalogu.
+ *
+ *  @returns  0 dla katalogu głównego
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+uint8_t lib_depth(void)
+{
+    return depth;
+}
+
+/*!
+ *  @brief    Otwiera plik WAV i sprawdza czy format jest obsługiwany.
+ *  @param fp
+ *            Obiekt pliku do otwarcia
+ *  @param name
+ *            Nazwa pliku WAV w bieżącym katalogu
+ *  @param dataSize
+ *            Zwracany rozmiar danych PCM w bajtach
+ *
+ *  @returns  WAV_OPEN_OK, WAV_OPEN_ERR_OPEN albo WAV_OPEN_ERR_FMT
+ *  @side effects:
+ *            Przy sukcesie plik zostaje otwarty ze wskaźnikiem na początku danych,
+ *            przy błędzie formatu jest zamykany.
+ */
+uint8_t lib_wavOpen(FIL* fp, const char* name, uint32_t* dataSize)
+{
+    LibTrack_t t;
+
+    if (f_open(fp, path_join(name), FA_READ) != FR_OK) {
+        return WAV_OPEN_ERR_OPEN;
+    }
+    if ((wav_header(fp, &t) == false) || (t.channels != WAV_REQUIRED_CHANNELS)
+        || (t.sampleRate != SAMPLE_RATE_8KHZ)) {
+        (void)f_close(fp);
+        return WAV_OPEN_ERR_FMT;
+    }
+    *dataSize = t.length;
+    return WAV_OPEN_OK;
+}
+
+/*!
+ *  @brief    Zwraca statystyki biblioteki.
+ *
+ *  @returns  Wskaźnik na statystyki modułu
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+LibStats_t* lib_stats(void)
+{
+    return &stats;
+}
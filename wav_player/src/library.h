@@ -0,0 +1,87 @@
+#ifndef __LIBRARY_H
+#define __LIBRARY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ff.h"
+
+/* Indeks utworów w każdym odwiedzonym katalogu: nagłówek i rekordy po
+   LIB_REC_SIZE bajtów, 16 rekordów w sektorze */
+#define LIB_INDEX_NAME "TRACKS.IDX"
+#define LIB_TITLES_NAME "TRACKS.NAM"   /* nazwy wyświetlane, rekord na utwór */
+#define LIB_REC_SIZE 32U
+#define LIB_NAME_LEN 13U
+#define LIB_TITLE_REC 32U       /* rekord pliku nazw, 16 na sektor */
+#define LIB_TITLE_LEN 21U       /* nazwa w oknie: tyle znaków mieści wiersz listy, z zerem */
+#define LIB_PAGE_ENTRIES 8U     /* okno nazw w RAM, niezależne od liczby utworów */
+
+/* Katalogi: głębokość, ścieżka bieżącego katalogu i pamięć pozycji odwiedzonych */
+#define LIB_DIR_DEPTH 4U
+#define LIB_PATH_LEN (LIB_DIR_DEPTH * LIB_NAME_LEN)
+#define LIB_DIR_CACHE 8U
+
+/* Rodzaj wpisu w rekordzie */
+#define LIB_FLAG_DIR 0x01U      /* podkatalog */
+#define LIB_FLAG_PARENT 0x02U   /* ".." - powrót do katalogu nadrzędnego */
+
+/* Nagłówek WAV i obsługiwany format */
+#define WAV_HEADER_SIZE 44U
+#define WAV_RIFF_SIGNATURE 'R'
+#define WAV_RIFF_SIGNATURE2 'I'
+#define WAV_REQUIRED_CHANNELS 1U
+#define SAMPLE_RATE_8KHZ 8000U
+
+/* Wynik otwarcia pliku WAV */
+#define WAV_OPEN_OK 0U
+#define WAV_OPEN_ERR_OPEN 1U
+#define WAV_OPEN_ERR_FMT 2U
+
+typedef struct {
+    char name[LIB_NAME_LEN];    /* nazwa 8.3 zakończona zerem */
+    uint32_t startCluster;      /* pierwszy klaster pliku */
+    uint32_t dataOffset;        /* początek danych PCM w pliku */
+    uint32_t length;            /* rozmiar danych PCM w bajtach */
+    uint16_t sampleRate;
+    uint8_t channels;
+    uint8_t bits;
+    int8_t gainDb;              /* korekta głośności utworu, 0 gdy brak */
+    uint8_t flags;              /* LIB_FLAG_x, 0 dla utworu */
+} LibTrack_t;
+
+/* Statystyki do odczytu debuggerem */
+typedef struct {
+    uint32_t loads;
+    uint32_t loadUs;            /* wczytanie nagłówka indeksu */
+    uint32_t rebuilds;
+    uint32_t verifies;
+    uint32_t steps;
+    uint32_t stepMaxUs;
+    uint32_t errors;
+    uint32_t pageHits;          /* nazwy z okna w RAM */
+    uint32_t pageReads;         /* rekordy doczytane do okna */
+    uint32_t dirHits;           /* powrót do katalogu z zapamiętaną pozycją */
+    uint32_t dirMisses;
+    uint32_t directLists;       /* listy tylko do odczytu, gdy indeksu nie dało się zapisać */
+} LibStats_t;
+
+void lib_init(uint32_t (*clockUs)(void));
+bool lib_load(void);
+void lib_verify(void);
+void lib_rebuild(void);
+bool lib_step(void);
+bool lib_busy(void);
+bool lib_takeChanged(void);
+bool lib_readOnly(void);
+int32_t lib_count(void);
+bool lib_get(int32_t index, LibTrack_t* out);
+const char* lib_name(int32_t index);
+int32_t lib_findCluster(uint32_t cluster, int32_t near);
+int32_t lib_enter(const LibTrack_t* entry, int32_t pos);
+uint8_t lib_depth(void);
+uint16_t lib_pathHash(void);
+bool lib_enterPath(uint16_t hash);
+uint8_t lib_wavOpen(FIL* fp, const char* name, uint32_t* dataSize);
+LibStats_t* lib_stats(void);
+
+#endif /* __LIBRARY_H */
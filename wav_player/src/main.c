@@ -14,11 +14,27 @@
 
 #include "joystick.h"
 #include "pca9532.h"
+#include "i2cq.h"
 
 #include "oled.h"
 #include <stdbool.h>
 #include <string.h>
 
+#include "ui.h"
+#include "spectrum.h"
+#include "quadrature.h"
+#include "input.h"
+#include "sched.h"
+#include "pot.h"
+#include "vu.h"
+#include "amp.h"
+#include "power.h"
+#include "xfade.h"
+#include "resume.h"
+#include "library.h"
+#include "screen.h"
+#include "sdstream.h"
+
 #define WAV_BUF_SIZE 512U
 #define HALF_BUF_SIZE  (WAV_BUF_SIZE/2U)
 
@@ -27,55 +43,111 @@
 #define ROT_B_PORT 2U
 #define ROT_B_PIN 1U
 
-/* zapisywanie danych o znalezionych plikach na karcie SD */
-#define MAX_FILES 9U
-#define MAX_FILENAME_LEN 64U
+/* Stałe dla listy utworów na OLED */
+#define LIST_ROWS SCREEN_LIST_ROWS
+#define STATUS_ROW SCREEN_STATUS_ROW
+#define PROGRESS_UPDATE_MS 1000U
+#define PCM_BYTES_PER_SAMPLE 2U
+#define SEEK_STEP_S 5            /* przewijanie joystickiem w lewo/prawo */
+
+#define LED_BAR_LEDS 8U
+#define LED_BAR_MASK 0x00FFU
+#define LED_FRAME_MS VU_FRAME_MS /* zapis zmian linijki LED najwyżej raz na ramkę */
+#define VOLUME_SHOW_MS 1500U     /* po zmianie głośności linijka pokazuje ją zamiast VU */
+
+#define ADC_SAMPLE_MS 10U       /* start konwersji potencjometru z SysTick */
+
+/* Obwiednie wzmocnienia w torze próbek (w próbkach 8 kHz) */
+#define FADE_SAMPLES 128U       /* 16 ms narastania/wygaszania przy starcie, stopie i pauzie */
+#define FADE_TIMEOUT_MS 20U     /* ograniczenie oczekiwania na koniec wygaszania */
+#define VOLUME_RAMP_SAMPLES (HALF_BUF_SIZE / PCM_BYTES_PER_SAMPLE) /* zmiana głośności na jeden blok */
+
+/* Zadania planisty, mniejszy numer = wyższy priorytet */
+#define TASK_AUDIO 0U   /* doczytywanie buforów, budzone przez Timer1 */
+#define TASK_INPUT 1U   /* zdarzenia wejścia, budzone przez SysTick */
+#define TASK_VOLUME 2U  /* zmiana głośności, budzone przez przerwanie ADC */
+#define TASK_TICK  3U   /* zadania okresowe, co 1 ms z SysTick */
+#define TASK_UI    4U   /* rysowanie interfejsu i analizator widma */
+#define TASK_LIBRARY 5U /* sprawdzanie i przebudowa indeksu utworów w tle */
+
+#define POWER_BTN_PORT 0U
+#define POWER_BTN_PIN 4U
 
 #define SEKUNDA 1000000U
 
 /* Stałe dla DAC */
 #define DAC_MIDDLE_VALUE 512U
 #define DAC_MAX_VALUE 1023U
-#define VOLUME_AMPLIFICATION_FACTOR 6U
-#define VOLUME_AMPLIFICATION_DIVISOR 5U
-#define PCM_MAX_POSITIVE 32767
-#define PCM_MAX_NEGATIVE -32768
 #define PCM_OFFSET 32768U
 #define VOLUME_MAX 100U
-#define UINT16_MAX_VALUE 65535U
 
 /* Stałe dla timera */
 #define TIMER_PRESCALE_VALUE 1U
-#define SAMPLE_RATE_8KHZ 8000U
 #define TIMER_MATCH_VALUE_8KHZ 125U
 
-/* Stałe dla I2C */
-#define I2C_RETRANSMISSIONS_MAX 3U
-#define I2C_DELAY_MS 10000U
+/* Następny utwór jest otwierany, gdy do końca bieżącego (albo do początku przejścia)
+   zostaje tyle danych (128 ms) */
+#define PREFETCH_BYTES (8U * HALF_BUF_SIZE)
+
+/* Start: czas na ustalenie stanu styku detekcji karty (dwie zgodne próbki co 1 ms) */
+#define BOOT_SD_DETECT_MS 3U
+
+/* Etapy startu, wykonywane krokami w boot_step() */
+typedef enum {
+    BOOT_SD_DETECT = 0,     /* czekanie na stan detekcji karty */
+    BOOT_SD_INIT,           /* odpytywanie karty ACMD41 co 1 ms */
+    BOOT_MOUNT,             /* montowanie FAT i wczytanie indeksu utworów */
+    BOOT_SCAN,              /* budowa indeksu, jeden wpis katalogu na krok */
+    BOOT_DONE,
+    BOOT_FAIL
+} BootState;
 
-/* Stałe dla WAV */
-#define WAV_HEADER_SIZE 44U
-#define WAV_RIFF_SIGNATURE 'R'
-#define WAV_RIFF_SIGNATURE2 'I'
-#define WAV_REQUIRED_CHANNELS 1U
+/* Oś czasu startu w mikrosekundach od resetu, do odczytu debuggerem */
+typedef struct {
+    uint32_t sdStartUs;     /* CMD0/CMD8 wysłane */
+    uint32_t oledUs;        /* ekran zainicjalizowany */
+    uint32_t sdReadyUs;     /* karta wyszła ze stanu bezczynności */
+    uint32_t sdPolls;
+    uint32_t mountUs;
+    uint32_t scanUs;        /* lista utworów wczytana */
+    uint32_t firstSampleUs; /* start Timer1 - pierwsza próbka 125 us później */
+} BootTrace_t;
+
+/* Widok w górnej części ekranu (wiersze 0-5) */
+typedef enum {
+    VIEW_LIST = 0,
+    VIEW_SPECTRUM
+} ViewMode;
 
 typedef struct {
     bool isPlaying;
     int32_t currentTrack;
+    int32_t playingTrack;
     uint32_t volume;
     bool screenState;
-    int32_t fileCount;
-    char fileList[MAX_FILES][MAX_FILENAME_LEN];
+    ViewMode view;
+    int32_t fileCount;      /* utwory w indeksie, nazwy w oknie lib_name() */
     FIL currentFile;
-    uint8_t wavBuf[WAV_BUF_SIZE];
+    FIL nextFile;           /* następny utwór otwarty przed końcem bieżącego */
+    int32_t nextTrack;      /* utwór, dla którego próbowano otwarcia, -1 brak */
+    uint32_t nextDataSize;
+    uint32_t nextRemaining;  /* dane następnego utworu nieodczytane jeszcze przez przejście */
+    bool nextReady;
+    uint16_t nextName;      /* skróty nazwy i katalogu następnego utworu do zapisu stanu */
+    uint16_t nextPath;
+    uint16_t playIndex;     /* odtwarzany utwór do zapisu stanu, także gdy lista */
+    uint16_t playName;      /* pokazuje inny katalog */
+    uint16_t playPath;
+    uint32_t xfadeS;        /* długość przejścia między utworami, 0-XFADE_MAX_S */
+    bool xfading;
+    uint32_t xfadePos;      /* bajty bieżącego utworu zmiksowane w przejściu */
+    uint32_t xfadeTotal;
     uint32_t sampleRate;
     uint32_t dataSize;
     uint16_t numChannels;
-    uint32_t delay;
-    uint32_t bufferPos;
     uint32_t remainingData;
-    bool needNewBuffer;
     bool isPaused;
+    bool powerPaused;       /* pauza wymuszona wyłączeniem ekranu przyciskiem zasilania */
     uint8_t activeBuf;
     bool bufReady[2];
     uint32_t bufPos;
@@ -84,37 +156,89 @@ typedef struct {
 PlayerState player = {
     .isPlaying = false,
     .currentTrack = 0,
+    .playingTrack = -1,
+    .nextTrack = -1,
+    .nextDataSize = 0U,
+    .nextRemaining = 0U,
+    .nextReady = false,
+    .nextName = 0U,
+    .nextPath = 0U,
+    .playIndex = 0U,
+    .playName = 0U,
+    .playPath = 0U,
+    .xfadeS = XFADE_DEFAULT_S,
+    .xfading = false,
+    .xfadePos = 0U,
+    .xfadeTotal = 0U,
     .volume = 50U,
     .screenState = true,
+    .view = VIEW_LIST,
     .fileCount = 0,
     .sampleRate = 0U,
     .dataSize = 0U,
     .numChannels = 0U,
-    .delay = 0U,
-    .bufferPos = 0U,
     .remainingData = 0U,
-    .needNewBuffer = false,
     .isPaused = false,
+    .powerPaused = false,
     .activeBuf = 0U,
     .bufReady = {false, false},
     .bufPos = 0U
 };
 
-typedef struct {
-    uint8_t lastStateA;
-    uint8_t lastStateB;
-    uint32_t lastDebounceTime;
-    bool isInitialized;
-} RotaryEncoder_t;
-
 /* deklaracje zasobów dotyczących: enkodera, buforu wav, plików z karty SD, biblioteki Fatfs*/
 static uint8_t wavBuf[2][HALF_BUF_SIZE];
-static FILINFO Finfo;
+static uint8_t xfadeBuf[HALF_BUF_SIZE];     /* dane narastającego utworu w przejściu */
+static SdStream_t curStream;                /* odczyt player.currentFile całymi sektorami */
+static SdStream_t nextStream;               /* odczyt player.nextFile */
 static FATFS Fatfs[1];
 
+/* Dekoder enkodera obrotowego, licznik zatrzasków aktualizowany w EINT3_IRQHandler,
+   odczytywany w SysTick_Handler */
+static Quadrature_t encoder;
+
+/* Dostrojenie cyfrowe próbek w Q15 (AMP_TRIM_UNITY = 1.0), ustawiane przez set_volume */
+static int32_t outTrim = AMP_TRIM_UNITY;
+
+/* Bieżące wzmocnienie toru próbek w Q15, interpolowane liniowo w TIMER1_IRQHandler
+   o gainStep na próbkę przez rampLeft próbek, do gainTarget */
+static volatile int32_t outGain = 0;
+static volatile int32_t gainStep = 0;
+static volatile int32_t gainTarget = 0;
+static volatile uint32_t rampLeft = 0U;
+
 /* Licznik milisekund dla systemu */
 static volatile uint32_t msTicks = 0U;
 
+/* Czasy ostatnich zadań okresowych (ms) */
+static uint32_t lastProgress = 0U;
+static uint32_t lastStateSave = 0U;
+static uint32_t lastLedFrame = 0U;
+static uint32_t volumeShowUntil = 0U;
+static bool ledShowsVu = false;
+
+/* Środkowy przycisk przytrzymany - zmiana widoku zamiast pauzy po puszczeniu */
+static bool centerLong = false;
+/* Środkowy przycisk wciśnięty; obrót enkodera zmienia wtedy długość przejścia */
+static bool centerHeld = false;
+static bool centerTurned = false;
+
+/* Pomiar czasu kroków rysowania interfejsu (odczyt debuggerem) */
+typedef struct {
+    uint32_t slices;
+    uint32_t lastSliceUs;
+    uint32_t maxSliceUs;
+    uint32_t lastSliceBytes;
+    uint32_t maxSliceBytes;
+} UiStats_t;
+
+static UiStats_t uiStats = {0U, 0U, 0U, 0U, 0U};
+
+/* Stan startu przeplatanego */
+static BootState bootState = BOOT_SD_DETECT;
+static bool bootOled = false;
+static uint32_t bootLastPoll = 0U;
+static BootTrace_t bootTrace;
+
 /* Deklaracje funkcji */
 static void init_ssp(void);
 static void init_i2c(void);
@@ -122,13 +246,51 @@ static void init_adc(void);
 static void init_dac(void);
 static void button_init(void);
 static void rotary_init(void);
+static uint8_t rotary_read(void);
+static void move_selection(int32_t delta);
+static void set_xfade(int32_t delta);
+static uint8_t read_keys(void);
+static bool handle_input(const InputEvent_t* ev);
+static void play_track(int32_t track);
+static void play_track_from(int32_t track, uint32_t offset);
+static void save_state(void);
+static uint32_t restore_state(void);
+static void set_pause(bool pause);
+static void seek_wav(int32_t seconds);
 static void display_files(void);
-static void play_wav_file(const char* filename);
+static void play_wav_file(const char* filename, uint32_t offset);
+static bool fill_half(uint8_t* buf, uint32_t* len);
+static bool next_switch(void);
+static void prefetch_next(void);
+static void next_drop(void);
+static uint32_t xfade_bytes(void);
 static void stop_wav(void);
 static void set_volume(uint32_t vol);
+static void gain_ramp(int32_t target, uint32_t samples);
+static void fade_in(void);
+static void fade_out(void);
 static void led_bar_set(uint8_t volume);
+static void led_bar_show(uint32_t level, uint8_t peakLed);
+static void led_frame(uint32_t now);
 static uint32_t getTicks(void);
+static uint32_t getMicros(void);
+static bool audio_needs_refill(void);
+static void ui_step(void);
+static void set_view(ViewMode view);
+static void show_progress(void);
 static void init_Timer(void);
+static void task_audio(void);
+static void task_input(void);
+static void task_volume(void);
+static void task_tick(void);
+static void task_ui(void);
+static bool boot_step(void);
+static void boot_oled(void);
+static void boot_scanDone(void);
+static void task_library(void);
+static void load_list(void);
+static void list_reload(int32_t select);
+static void open_entry(int32_t track);
 
 /*!
  *  @brief    Zwraca aktualny timestamp dla systemu plików FAT.
@@ -160,16 +322,61 @@ static uint32_t getTicks(void)
     return msTicks;
 }
 
+/*!
+ *  @brief    Zwraca czas w mikrosekundach liczony z msTicks i licznika SysTick.
+ *
+ *  @returns  uint32_t z czasem od startu w mikrosekundach
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static uint32_t getMicros(void)
+{
+    uint32_t ms;
+    uint32_t val;
+
+    /* Ponowny odczyt jeśli SysTick przepełnił się w trakcie */
+    do {
+        ms = msTicks;
+        val = SysTick->VAL;
+    } while (ms != msTicks);
+
+    return (ms * 1000U) + ((SysTick->LOAD - val) / (SystemCoreClock / SEKUNDA));
+}
+
 /*!
  *  @brief    Obsługa przerwania systemowego.
  *
  *  @side effects:
  *            Inkrementuje globalną zmienną msTicks
  *            Wywołuje disk_timerproc() do obsługi karty SD
+ *            Próbkuje joystick, przycisk zasilania i enkoder, zdarzenia trafiają do kolejki
+ *            Budzi zadanie okresowe, a przy nowych zdarzeniach także zadanie wejścia
+ *            Co ADC_SAMPLE_MS uruchamia konwersję ADC, wynik odbiera ADC_IRQHandler
  */
 void SysTick_Handler(void) {
     msTicks++;
     disk_timerproc();
+    if (input_sample(msTicks, read_keys(), quad_takeDelta(&encoder)) == true) {
+        sched_signal(TASK_INPUT);
+    }
+    if ((msTicks % ADC_SAMPLE_MS) == 0U) {
+        ADC_StartCmd(LPC_ADC, ADC_START_NOW);
+    }
+    sched_signal(TASK_TICK);
+}
+
+/*!
+ *  @brief    Handler przerwania ADC - koniec konwersji potencjometru głośności.
+ *
+ *  @side effects:
+ *            Odczyt rejestru danych kanału kasuje flagę przerwania.
+ *            Przekazuje próbkę do filtru, przy zmianie poziomu budzi zadanie głośności.
+ */
+void ADC_IRQHandler(void)
+{
+    if (pot_feed(ADC_ChannelGetData(LPC_ADC, ADC_CHANNEL_0)) == true) {
+        sched_signal(TASK_VOLUME);
+    }
 }
 
 /*!
@@ -217,8 +424,8 @@ static void init_ssp(void)
  *
  *  @side effects:
  *            Konfiguruje piny P0.10 i P0.11 jako I2C2
- *            Inicjalizuje moduł I2C2 z częstotliwością 100 kHz
- *            Włącza moduł I2C2
+ *            Inicjalizuje moduł I2C2 w trybie Fast (400 kHz) z kolejką transakcji
+ *            obsługiwaną w przerwaniu - zapis do linijki LED nie blokuje pętli
  */
 static void init_i2c(void) {
     PINSEL_CFG_Type PinCfg;
@@ -231,8 +438,8 @@ static void init_i2c(void) {
     PinCfg.Pinnum = 11U;
     PINSEL_ConfigPin(&PinCfg);
 
-    I2C_Init(LPC_I2C2, 100000U);
-    I2C_Cmd(LPC_I2C2, ENABLE);
+    i2cq_init(I2CQ_CLOCK_FAST);
+    NVIC_SetPriority(I2C2_IRQn, 2U);
 }
 
 /*!
@@ -259,11 +466,16 @@ static void init_adc(void)
 
     /* Konfiguracja ADC:
      * Częstotliwość 200 kHz
-     * ADC kanał 0, bez przerwań
+     * ADC kanał 0, przerwanie po zakończeniu konwersji kanału
      */
     ADC_Init(LPC_ADC, 200000U);
-    ADC_IntConfig(LPC_ADC, ADC_CHANNEL_0, DISABLE);
+    pot_init();
+    ADC_IntConfig(LPC_ADC, ADC_ADGINTEN, DISABLE);
+    ADC_IntConfig(LPC_ADC, ADC_ADINTEN0, ENABLE);
     ADC_ChannelCmd(LPC_ADC, ADC_CHANNEL_0, ENABLE);
+
+    NVIC_SetPriority(ADC_IRQn, 3U);
+    NVIC_EnableIRQ(ADC_IRQn);
 }
 
 /*!
@@ -273,7 +485,7 @@ static void init_adc(void)
  *            Konfiguruje pin P0.26 jako DAC
  *            Inicjalizuje moduł DAC
  *            Konfiguruje piny sterujące wzmacniacza (P0.27, P0.28, P2.13)
- *            Aktywuje wzmacniacz przez ustawienie SHUTDN = 0
+ *            Aktywuje wzmacniacz i ustawia jego śledzony krok wzmocnienia na 0
  */
 static void init_dac(void) {
     PINSEL_CFG_Type PinCfg;
@@ -289,15 +501,8 @@ static void init_dac(void) {
     /* Inicjalizacja DAC */
     DAC_Init(LPC_DAC);
 
-    /* Konfiguracja wyjść wzmacniacza LM4811 (CLK, UP/DN, SHUTDN) */
-    GPIO_SetDir(0U, 1UL << 27, 1U); /* CLK */
-    GPIO_SetDir(0U, 1UL << 28, 1U); /* UP/DN */
-    GPIO_SetDir(2U, 1UL << 13, 1U); /* SHUTDN */
-
-    /* Wzmacniacz aktywny: SHUTDN = 0 */
-    GPIO_ClearValue(0U, 1UL << 27);
-    GPIO_ClearValue(0U, 1UL << 28);
-    GPIO_ClearValue(2U, 1UL << 13);
+    /* Wzmacniacz LM4811 (CLK, UP/DN, SHUTDN) */
+    amp_init();
 }
 
 /*!
@@ -329,9 +534,11 @@ static void button_init(void)
  *
  *  @side effects:
  *            Odczytuje próbki PCM z podwójnego bufora
- *            Przetwarza sygnał przez wzmocnienie i kontrolę głośności
+ *            Mnoży próbkę przez wzmocnienie outGain (dostrojenie między krokami
+ *            LM4811 i obwiednie), przesuwając je o krok rampy
  *            Wysyła wynik do DAC
  *            Przełącza między buforami gdy jeden się wyczerpie
+ *            i budzi zadanie doczytujące bufor
  *            Kasuje flagę przerwania Timer1
  */
 void TIMER1_IRQHandler(void) {
@@ -342,20 +549,24 @@ void TIMER1_IRQHandler(void) {
 
 		/* Odczyt próbki z bufora */
         uint8_t *buf = wavBuf[player.activeBuf];
-        int16_t samp = buf[player.bufPos] | (buf[player.bufPos+1] << 8);
-
-		/* Podgłośnienie i skalowanie */
-        int32_t amp = samp * 6/5;
-        amp = (amp>32767?32767:(amp<-32768?-32768:amp));
-        uint32_t u = (amp + 32768) * player.volume / 100;
-        uint16_t dac = u * 1023 / 65535;
-        DAC_UpdateValue(LPC_DAC, dac);
+        int32_t samp = (int16_t)(buf[player.bufPos] | (buf[player.bufPos+1] << 8));
+
+		/* Rampa wzmocnienia - ostatni krok dociąga dokładnie do celu */
+        if (rampLeft != 0U) {
+            rampLeft--;
+            outGain = (rampLeft == 0U) ? gainTarget : (outGain + gainStep);
+        }
+
+		/* Wzmocnienie cyfrowe, 16 bitów ze znakiem na 10 bitów DAC */
+        samp = (samp * outGain) >> 15;
+        DAC_UpdateValue(LPC_DAC, (uint32_t)(samp + (int32_t)PCM_OFFSET) >> 6);
         player.bufPos += 2;
 
         if (player.bufPos >= HALF_BUF_SIZE) {
             player.bufReady[player.activeBuf] = false;
             player.activeBuf ^= 1;
             player.bufPos = 0;
+            sched_signal(TASK_AUDIO);
         }
     }
     TIM_ClearIntPending(LPC_TIM1, TIM_MR0_INT);
@@ -365,76 +576,252 @@ void TIMER1_IRQHandler(void) {
  *  @brief    Otwiera i odtwarza plik WAV o podanej nazwie.
  *  @param filename
  *            Nazwa pliku WAV do odtworzenia
+ *  @param offset
+ *            Pozycja startu w bajtach danych PCM, 0 od początku
  *
  *  @side effects:
  *            Zatrzymuje aktualnie odtwarzany plik
- *            Otwiera nowy plik i sprawdza nagłówek WAV
- *            Wypełnia bufory danymi audio
+ *            Otwiera nowy plik, sprawdza nagłówek WAV i przewija do pozycji startu
+ *            Zeruje miernik VU i wypełnia bufory danymi audio
  *            Uruchamia timer dla próbkowania 8kHz
- *            Wyświetla status na ekranie OLED
+ *            Pokazuje czas i pasek postępu odtwarzania
  */
-static void play_wav_file(const char* filename) {
-    FRESULT fr;
-    UINT    br;
-    uint8_t hdr[WAV_HEADER_SIZE];
+static void play_wav_file(const char* filename, uint32_t offset) {
+    uint8_t res;
+    uint32_t len;
 
     stop_wav();
-    fr = f_open(&player.currentFile, filename, FA_READ);
-    if (fr != FR_OK) {
-        oled_putString(1U, 45U, (uint8_t*)"Open err", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+    res = lib_wavOpen(&player.currentFile, filename, &player.dataSize);
+    if (res == WAV_OPEN_ERR_OPEN) {
+        ui_setRow(STATUS_ROW, "Open err", OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
+        return;
+    }
+    if (res == WAV_OPEN_ERR_FMT) {
+        ui_setRow(STATUS_ROW, "Fmt err", OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
         return;
     }
 
-    f_read(&player.currentFile, hdr, WAV_HEADER_SIZE, &br);
-
-	/* Sprawdzenie nagłówka WAV */
-    player.sampleRate = (uint32_t)(hdr[24] | (hdr[25] << 8) | (hdr[26] << 16) | (hdr[27] << 24));
-    player.remainingData = (uint32_t)(hdr[40] | (hdr[41] << 8) | (hdr[42] << 16) | (hdr[43] << 24));
-    player.numChannels = (uint16_t)(hdr[22] | (hdr[23] << 8));
-
-    if ((hdr[0] != WAV_RIFF_SIGNATURE) || (hdr[1] != WAV_RIFF_SIGNATURE2) ||
-        (player.numChannels != WAV_REQUIRED_CHANNELS) || (player.sampleRate != SAMPLE_RATE_8KHZ)) {
-        oled_putString(1U, 45U, (uint8_t*)"Fmt err", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+    /* Start od zapisanej pozycji */
+    offset &= ~(PCM_BYTES_PER_SAMPLE - 1U);
+    if (offset >= player.dataSize) {
+        offset = 0U;
+    }
+    if ((offset > 0U) && (f_lseek(&player.currentFile, WAV_HEADER_SIZE + offset) != FR_OK)) {
         f_close(&player.currentFile);
+        ui_setRow(STATUS_ROW, "Seek err", OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
         return;
     }
+    sds_attach(&curStream, &player.currentFile);
 
 	/* Inicjalizacja stanu odtwarzacza */
+    player.sampleRate = SAMPLE_RATE_8KHZ;
+    player.numChannels = WAV_REQUIRED_CHANNELS;
+    player.remainingData = player.dataSize - offset;
     player.isPlaying = true;
     player.isPaused = false;
     player.activeBuf = 0U;
     player.bufPos = 0U;
+    vu_reset();
 
 	/* Wstępne wypełnienie obu połówek bufora */
     for (int32_t i = 0; i < 2; i++) {
-        UINT toRead = (player.remainingData > HALF_BUF_SIZE) ? HALF_BUF_SIZE : player.remainingData;
-        fr = f_read(&player.currentFile, wavBuf[i], toRead, &br);
-        player.bufReady[i] = (br > 0U);
-        player.remainingData -= br;
+        player.bufReady[i] = (fill_half(wavBuf[i], &len) == true) && (len > 0U);
     }
 
-	/* Start timera dla próbkowania 8 kHz */
+	/* Wybudzenie toru audio i start timera dla próbkowania 8 kHz z narastaniem */
+    power_wake(getTicks());
+    fade_in();
     TIM_Cmd(LPC_TIM1, ENABLE);
-    oled_putString(1U, 45U, (uint8_t*)"PLAYING...", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+    if (bootTrace.firstSampleUs == 0U) {
+        bootTrace.firstSampleUs = getMicros();
+    }
+    show_progress();
+}
+
+/*!
+ *  @brief    Wypełnia połówkę bufora danymi, na końcu pliku kontynuując następnym utworem.
+ *  @param buf
+ *            Połówka bufora (HALF_BUF_SIZE bajtów)
+ *  @param len
+ *            Zwracana liczba bajtów danych w połówce
+ *
+ *  @returns  false przy błędzie odczytu
+ *  @side effects:
+ *            W ostatnich player.xfadeS sekundach utworu czyta ten sam fragment z obu
+ *            plików i miesza je; potem przechodzi na następny utwór bez przerwy
+ *            w próbkach. Gdy danych zabraknie, reszta połówki jest wypełniana ciszą.
+ *            Oba pliki czytane są przez strumienie z prywatnymi buforami sektora:
+ *            w przejściu z karty idzie jeden sektor na 512 bajtów każdego utworu.
+ */
+static bool fill_half(uint8_t* buf, uint32_t* len)
+{
+    uint32_t filled = 0U;
+    uint32_t xfBytes;
+    uint32_t toRead;
+    uint32_t br;
+    uint32_t brNext;
+
+    while (filled < HALF_BUF_SIZE) {
+        if ((player.remainingData == 0U) && (next_switch() == false)) {
+            break;
+        }
+
+        /* początek przejścia: następny utwór musi mieć dość danych */
+        xfBytes = xfade_bytes();
+        if ((player.xfading == false) && (player.nextReady == true) && (xfBytes > 0U)
+            && (player.remainingData <= xfBytes) && (player.nextRemaining >= player.remainingData)) {
+            player.xfading = true;
+            player.xfadePos = 0U;
+            player.xfadeTotal = player.remainingData;
+            xfade_begin();
+        }
+
+        toRead = HALF_BUF_SIZE - filled;
+        if (toRead > player.remainingData) {
+            toRead = player.remainingData;
+        }
+        if ((sds_read(&curStream, &buf[filled], toRead, &br) != FR_OK) || (br == 0U)) {
+            *len = filled;
+            return false;
+        }
+        player.remainingData -= br;
+
+        if (player.xfading == true) {
+            if (sds_read(&nextStream, &xfadeBuf[filled], br, &brNext) != FR_OK) {
+                brNext = 0U;
+            }
+            if (brNext < br) {
+                (void)memset(&xfadeBuf[filled + brNext], 0, br - brNext);
+            }
+            player.nextRemaining -= brNext;
+            xfade_mix(&buf[filled], &xfadeBuf[filled], br, player.xfadePos, player.xfadeTotal);
+            player.xfadePos += br;
+        }
+        filled += br;
+    }
+
+    if ((filled > 0U) && (filled < HALF_BUF_SIZE)) {
+        (void)memset(&buf[filled], 0, HALF_BUF_SIZE - filled);
+    }
+    *len = filled;
+    return true;
+}
+
+/*!
+ *  @brief    Przełącza odczyt na następny utwór otwarty przez prefetch_next().
+ *
+ *  @returns  true jeśli następny utwór był gotowy
+ *  @side effects:
+ *            Zamyka bieżący plik i przejmuje następny (razem z buforem sektora jego
+ *            strumienia) od miejsca, w którym skończyło się przejście; aktualizuje
+ *            numer utworu, listę i pasek postępu.
+ *            Timer1 pracuje bez przerwy.
+ */
+static bool next_switch(void)
+{
+    if (player.nextReady == false) {
+        return false;
+    }
+    f_close(&player.currentFile);
+    player.currentFile = player.nextFile;
+    curStream = nextStream;
+    curStream.fp = &player.currentFile;
+    player.dataSize = player.nextDataSize;
+    player.remainingData = player.nextRemaining;
+    player.playIndex = (uint16_t)player.nextTrack;
+    player.playName = player.nextName;
+    player.playPath = player.nextPath;
+    /* po zmianie katalogu w trakcie przejścia utworu może nie być na liście */
+    player.playingTrack = (player.nextTrack < player.fileCount) ? player.nextTrack : -1;
+    if (player.playingTrack >= 0) {
+        player.currentTrack = player.playingTrack;
+    }
+    player.nextReady = false;
+    player.xfading = false;
+    display_files();
+    show_progress();
+    return true;
+}
+
+/*!
+ *  @brief    Otwiera następny utwór z listy i sprawdza jego nagłówek.
+ *
+ *  @side effects:
+ *            Jedna próba na utwór; przy błędzie albo na podkatalogu odtwarzanie
+ *            skończy się na bieżącym utworze.
+ */
+static void prefetch_next(void)
+{
+    LibTrack_t t;
+    int32_t track = player.playingTrack + 1;
+
+    if ((player.playingTrack < 0) || (track >= player.fileCount) || (track == player.nextTrack)
+        || (player.nextReady == true)) {
+        return;
+    }
+    player.nextTrack = track;
+    player.nextReady = (lib_get(track, &t) == true) && ((t.flags & LIB_FLAG_DIR) == 0U)
+        && (lib_wavOpen(&player.nextFile, t.name, &player.nextDataSize) == WAV_OPEN_OK);
+    player.nextRemaining = player.nextDataSize;
+    if (player.nextReady == true) {
+        sds_attach(&nextStream, &player.nextFile);
+        player.nextName = resume_hash(t.name);
+        player.nextPath = lib_pathHash();
+    }
+}
+
+/*!
+ *  @brief    Porzuca otwarty zawczasu następny utwór i trwające przejście.
+ *
+ *  @side effects:
+ *            Zamyka plik następnego utworu; zostanie otwarty ponownie przez
+ *            prefetch_next() gdy odtwarzanie znów zbliży się do końca utworu.
+ */
+static void next_drop(void)
+{
+    if (player.nextReady == true) {
+        f_close(&player.nextFile);
+        player.nextReady = false;
+    }
+    player.nextTrack = -1;
+    player.xfading = false;
+}
+
+/*!
+ *  @brief    Długość przejścia między utworami w bajtach danych.
+ *
+ *  @returns  player.xfadeS sekund danych PCM (ograniczone do XFADE_MAX_S)
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static uint32_t xfade_bytes(void)
+{
+    uint32_t sec = (player.xfadeS > XFADE_MAX_S) ? XFADE_MAX_S : player.xfadeS;
+
+    return sec * SAMPLE_RATE_8KHZ * WAV_REQUIRED_CHANNELS * PCM_BYTES_PER_SAMPLE;
 }
 
 /*!
  *  @brief    Zatrzymuje odtwarzanie pliku WAV.
  *
  *  @side effects:
- *            Wyłącza timer próbkowania
- *            Zamyka aktualnie otwarty plik
- *            Ustawia DAC na wartość środkową (cisza)
+ *            Wygasza wyjście i wyłącza timer próbkowania
+ *            Zamyka aktualnie otwarty plik i otwarty zawczasu następny
+ *            Usypia tor audio (DAC na środek, wyłączony wzmacniacz, Timer1 bez zegara)
  *            Resetuje flagi odtwarzania
  */
 static void stop_wav(void) {
     if (player.isPlaying) {
+        fade_out();
         player.isPlaying = false;
         player.isPaused = false;
+        player.powerPaused = false;
+        player.playingTrack = -1;
         TIM_Cmd(LPC_TIM1, DISABLE);
         f_close(&player.currentFile);
-        DAC_UpdateValue(LPC_DAC, DAC_MIDDLE_VALUE);
+        power_sleep();
     }
+    next_drop();
 }
 
 /*!
@@ -444,7 +831,7 @@ static void stop_wav(void) {
  *            Konfiguruje Timer1 z prescalerem 1 mikrosekundy
  *            Ustawia match value na 125 mikrosekund (8kHz)
  *            Włącza przerwania Timer1
- *            Uruchamia timer
+ *            Timer zostaje zatrzymany - uruchamia go start odtwarzania
  */
 static void init_Timer(void)
 {
@@ -474,9 +861,6 @@ static void init_Timer(void)
 
     /* Włącz przerwania */
     NVIC_EnableIRQ(TIMER1_IRQn);
-
-    /* Włącz timer */
-    TIM_Cmd(LPC_TIM1, ENABLE);
 }
 
 /*!
@@ -507,279 +891,1256 @@ static void rotary_init(void)
 	/* Ustawienie jako wejście */
     GPIO_SetDir(ROT_A_PORT, (1U << ROT_A_PIN), 0U);
     GPIO_SetDir(ROT_B_PORT, (1U << ROT_B_PIN), 0U);
+
+    quad_init(&encoder, rotary_read());
+
+    /* Przerwania na obu zboczach obu linii; GPIO_IntCmd nadpisuje rejestr, więc jedna maska */
+    GPIO_IntCmd(ROT_A_PORT, (1U << ROT_A_PIN) | (1U << ROT_B_PIN), 0U);
+    GPIO_IntCmd(ROT_A_PORT, (1U << ROT_A_PIN) | (1U << ROT_B_PIN), 1U);
+    GPIO_ClearInt(ROT_A_PORT, (1U << ROT_A_PIN) | (1U << ROT_B_PIN));
+
+    /* Niższy priorytet niż Timer1, aby obsługa enkodera nie opóźniała próbek audio */
+    NVIC_SetPriority(EINT3_IRQn, 2U);
+    NVIC_EnableIRQ(EINT3_IRQn);
 }
 
 /*!
- *  @brief    Ustawia linijkę LED zgodnie z poziomem głośności.
- *  @param volume
- *            Poziom głośności w zakresie 0-100
+ *  @brief    Odczytuje stan linii enkodera.
  *
+ *  @returns  Linia A na bicie 1, linia B na bicie 0
  *  @side effects:
- *            Aktualizuje stan diód LED na linijce zgodnie z głośnością.
- *            Proporcjonalnie włącza LED od dołu do góry.
+ *            Brak efektów ubocznych
  */
-static void led_bar_set(uint8_t volume) {
-    uint16_t ledOn = 0;
-    uint16_t ledOff = 0xFFFF;  // Wszystkie LED domyślnie wyłączone
-    uint8_t ledsToLight = 0;
-    int i;
+static uint8_t rotary_read(void)
+{
+    uint32_t port = GPIO_ReadValue(ROT_A_PORT);
 
-    // 0-2%: wszystkie LED wyłączone
-    if (volume <= 2) {
-        ledOn = 0;
-        ledOff = 0xFFFF;
-    }
-    // 2-100%: proporcjonalnie włącz LED
-    else {
-        ledsToLight = (volume * 8 +99) / 100;
-        // Włącz odpowiednią liczbę LED od dołu
-        for (i = 0; i < ledsToLight && i < 8; i++) {
-            ledOn |= (1 << i);
-        }
+    return (uint8_t)((((port >> ROT_A_PIN) & 1U) << 1) | ((port >> ROT_B_PIN) & 1U));
+}
 
-        // Wyłącz pozostałe LED
-        for (i = ledsToLight; i < 8; i++) {
-            ledOff |= (1 << i);
-        }
-    }
+/*!
+ *  @brief    Handler przerwania GPIO (wspólny z EINT3) - dekoduje zbocza enkodera.
+ *
+ *  @side effects:
+ *            Kasuje flagi przerwań linii enkodera przed odczytem pinów, więc zbocze
+ *            które nastąpi w trakcie obsługi wywoła przerwanie ponownie.
+ *            Aktualizuje licznik zatrzasków dekodera.
+ */
+void EINT3_IRQHandler(void)
+{
+    uint32_t mask = (1U << ROT_A_PIN) | (1U << ROT_B_PIN);
 
-    // Ustaw stan LED
-    pca9532_setLeds(ledOn, ledOff);
+    if (((LPC_GPIOINT->IO2IntStatR | LPC_GPIOINT->IO2IntStatF) & mask) != 0U) {
+        GPIO_ClearInt(ROT_A_PORT, mask);
+        (void)quad_update(&encoder, rotary_read());
+    }
 }
 
-
 /*!
- *  @brief    Wyświetla listę plików WAV na ekranie OLED z oznaczeniem aktualnie wybranego utworu.
- * 
+ *  @brief    Przesuwa zaznaczenie na liście utworów.
+ *  @param delta
+ *            Liczba pozycji (ujemna w górę listy)
+ *
  *  @side effects:
- *            Czyści ekran OLED i wyświetla listę plików z player.fileList.
- *            Wybrany utwór jest oznaczony symbolem ">" i odwróconymi kolorami.
- *            Jeśli ekran jest wyłączony (player.screenState == false), funkcja kończy działanie wcześniej.
+ *            Zmienia player.currentTrack w granicach listy i odświeża listę.
  */
-static void display_files(void)
+static void move_selection(int32_t delta)
 {
-    int32_t i;
+    int32_t track;
 
-    /* Sprawdź czy ekran jest włączony */
-    if (player.screenState == false) {
+    if (player.fileCount <= 0) {
         return;
     }
-
-	/* Wyczyść ekran */
-    oled_clearScreen(OLED_COLOR_WHITE);
-
-    /* Oznaczenie aktualnie wybranego pliku */
-    for (i = 0; i < player.fileCount; i++) {
-        if (i == player.currentTrack) {
-            /* Wyróżnienie aktualnego utworu */
-            oled_putString(1, 1 + (i * 8), (uint8_t*)"> ", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-            oled_putString(10, 1 + (i * 8), (uint8_t*)player.fileList[i], OLED_COLOR_WHITE, OLED_COLOR_BLACK);
-        }
-        else {
-            oled_putString(1, 1 + (i * 8), (uint8_t*)"  ", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-            oled_putString(10, 1 + (i * 8), (uint8_t*)player.fileList[i], OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-        }
+    track = player.currentTrack + delta;
+    if (track < 0) {
+        track = 0;
+    }
+    else if (track >= player.fileCount) {
+        track = player.fileCount - 1;
+    }
+    else {
+        /* w zakresie listy */
+    }
+    if (track != player.currentTrack) {
+        player.currentTrack = track;
+        display_files();
     }
 }
 
 /*!
- *  @brief    Ustawia poziom głośności i aktualizuje linijkę diodową.
- *  @param vol
- *            Poziom głośności w zakresie 0-100. Wartości powyżej 100 są ograniczane do 100.
- * 
+ *  @brief    Zmienia długość przejścia między utworami.
+ *  @param delta
+ *            Zmiana w sekundach
+ *
  *  @side effects:
- *            Modyfikuje player.volume.
+ *            Ogranicza długość do 0-XFADE_MAX_S i pokazuje ją w wierszu statusu do
+ *            następnej aktualizacji czasu odtwarzania. Zgłasza zapis stanu.
+ *            Trwające przejście kończy się z dotychczasową długością.
  */
-static void set_volume(uint32_t vol)
+static void set_xfade(int32_t delta)
 {
-    uint32_t limited_vol = vol;
+    int32_t sec = (int32_t)player.xfadeS + delta;
+    char msg[UI_ROW_LEN + 1U];
 
-	/* Ograniczenie głośności do zakresu 0-100 */
-    if (limited_vol > VOLUME_MAX) {
-        limited_vol = VOLUME_MAX;
+    if (sec < 0) {
+        sec = 0;
+    }
+    else if (sec > (int32_t)XFADE_MAX_S) {
+        sec = (int32_t)XFADE_MAX_S;
     }
+    else {
+        /* w zakresie */
+    }
+    player.xfadeS = (uint32_t)sec;
 
-    player.volume = limited_vol;
-    led_bar_set((uint8_t)player.volume);
+    if (sec == 0) {
+        (void)snprintf(msg, sizeof(msg), "Przejscie: brak");
+    }
+    else {
+        (void)snprintf(msg, sizeof(msg), "Przejscie: %d s", (int)sec);
+    }
+    ui_setRow(STATUS_ROW, msg, OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
+    lastProgress = getTicks();
+    save_state();
 }
 
 /*!
- *  @brief    Główna funkcja programu - inicjalizuje system i obsługuje pętlę główną odtwarzacza WAV.
- *  @returns  Kod zakończenia programu: 1 w przypadku błędu, 0 w przypadku normalnego zakończenia
- * 
+ *  @brief    Odczytuje surowy stan klawiszy, wywoływana z SysTick_Handler.
+ *
+ *  @returns  Bity INPUT_KEY_x, 1 = wciśnięty
  *  @side effects:
- *            Inicjalizuje wszystkie peryferia.
- *            Montuje, weryfikuje kartę SD i skanuje pliki WAV.
- *            Uruchamia pętlę główną obsługującą odtwarzanie muzyki i interfejs użytkownika.
- *            Wyświetla informacje na ekranie OLED.
+ *            Brak efektów ubocznych
  */
-int main(void) {
-    DSTATUS stat;
-    FRESULT fr;
-    DIR dir;
-    uint32_t lastADCCheck = 0U;
-    bool lastButtonPower = true;
-    bool screenNeedsUpdate = false;
-    char msg[32];
-    char* ext;
-    uint32_t now;
-    bool btnPower;
-    uint32_t v;
-    int32_t volume_diff;
-    int32_t i;
-    UINT br;
-    UINT toRead;
-
-    SystemInit();
-	/* Inicjalizacja zegara systemowego 1 ms*/
-    SysTick_Config(SystemCoreClock / 1000U);
-
-    /* krótkie opóźnienie dla stabilizacji systemu */
-    Timer0_us_Wait(100000U);
-
-    init_ssp();
-    init_i2c();
-    init_adc();
-    button_init();
-    rotary_init();
-    init_dac();
-    init_Timer();
-	pca9532_init();
-    joystick_init();
-    Timer0_us_Wait(SEKUNDA);
+static uint8_t read_keys(void)
+{
+    uint8_t keys = joystick_read();
 
-    oled_init();
-    oled_clearScreen(OLED_COLOR_WHITE);
-    oled_putString(1, 1, (uint8_t*)"WAV Player", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-    oled_putString(1, 10, (uint8_t*)"Init...", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+    if ((GPIO_ReadValue(POWER_BTN_PORT) & (1UL << POWER_BTN_PIN)) == 0U) {
+        keys |= INPUT_KEY_POWER;
+    }
+    return keys;
+}
 
-    /* Ustawienie początkowego poziomu głośności */
-    set_volume(50U);
-    led_bar_set((uint8_t)player.volume);
+/*!
+ *  @brief    Odtwarza utwór z listy i zaznacza go.
+ *  @param track
+ *            Indeks utworu, ograniczany do zakresu listy
+ *
+ *  @side effects:
+ *            Zmienia player.currentTrack i player.playingTrack, odświeża listę.
+ */
+static void play_track(int32_t track)
+{
+    play_track_from(track, 0U);
+}
 
-	/* Inicjalizacja karty SD */
-    stat = disk_initialize(0);
+/*!
+ *  @brief    Odtwarza utwór z listy od podanej pozycji i zaznacza go.
+ *  @param track
+ *            Indeks utworu, ograniczany do zakresu listy
+ *  @param offset
+ *            Pozycja startu w bajtach danych PCM
+ *
+ *  @side effects:
+ *            Zmienia player.currentTrack i player.playingTrack, odświeża listę.
+ *            Zgłasza nowy stan do zapisu w EEPROM.
+ *            Podkatalog jest tylko zaznaczany - wejście do niego to open_entry().
+ */
+static void play_track_from(int32_t track, uint32_t offset)
+{
+    LibTrack_t t;
 
-	/* Sprawdzenie statusu karty SD */
-    if ((stat & STA_NOINIT) != 0U) {
-        oled_putString(1, 19, (uint8_t*)"nie init.", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+    if (player.fileCount <= 0) {
+        return;
     }
-
-    if ((stat & STA_NODISK) != 0U) {
-        oled_putString(1, 28, (uint8_t*)"brak karty", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+    if (track < 0) {
+        track = 0;
     }
-
-    oled_clearScreen(OLED_COLOR_WHITE);
-
-    /* Montowanie karty SD i inicjalizacja FAT */
-    fr = f_mount(0, &Fatfs[0]);
-    if (fr != FR_OK) {
-        oled_putString(1, 20, (uint8_t*)"err. mont. SD", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-        return 1;
+    else if (track >= player.fileCount) {
+        track = player.fileCount - 1;
     }
     else {
-        oled_putString(1, 20, (uint8_t*)"SD OK", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+        /* w zakresie listy */
     }
-
-    /* Otwarcie katalogu głównego */
-    fr = f_opendir(&dir, "/");
-    if (fr != FR_OK) {
-        oled_putString(1, 30, (uint8_t*)"err. otw. dir", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-        return 1;
+    player.currentTrack = track;
+    display_files();
+    if (lib_get(track, &t) == false) {
+        ui_setRow(STATUS_ROW, "Open err", OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
+        return;
+    }
+    if ((t.flags & LIB_FLAG_DIR) != 0U) {
+        return;
     }
+    play_wav_file(t.name, offset);
+    player.playingTrack = (player.isPlaying == true) ? track : -1;
+    player.playIndex = (uint16_t)track;
+    player.playName = resume_hash(t.name);
+    player.playPath = lib_pathHash();
+    save_state();
+}
 
-    /* Skanowanie plików WAV */
-    player.fileCount = 0;
-    while (player.fileCount < MAX_FILES) {
-        /* Odczytanie kolejnego wpisu w katalogu */
-        fr = f_readdir(&dir, &Finfo);
-        if ((fr != FR_OK) || (Finfo.fname[0] == 0)) {
-            break;
-        }
+/*!
+ *  @brief    Otwiera zaznaczony wpis: odtwarza utwór albo wchodzi do katalogu.
+ *  @param track
+ *            Indeks wpisu na liście
+ *
+ *  @side effects:
+ *            Przy katalogu odtwarzanie trwa dalej, lista pokazuje nowy katalog
+ *            z zaznaczeniem zapamiętanym z poprzedniej wizyty.
+ */
+static void open_entry(int32_t track)
+{
+    LibTrack_t t;
+    int32_t pos;
 
-        /* Sprawdzenie czy to plik WAV */
-        if ((Finfo.fattrib & AM_DIR) == 0U) {
-            ext = strrchr(Finfo.fname, '.');
-            if ((ext != NULL) && ((strcmp(ext, ".WAV") == 0) || (strcmp(ext, ".wav") == 0))) {
-                /* Zapisanie nazwy pliku na liście */
-                (void)strncpy(player.fileList[player.fileCount], Finfo.fname, MAX_FILENAME_LEN - 1);
-                player.fileList[player.fileCount][MAX_FILENAME_LEN - 1] = '\0';
-                player.fileCount++;
-            }
-        }
+    if ((lib_get(track, &t) == false) || ((t.flags & LIB_FLAG_DIR) == 0U)) {
+        play_track(track);
+        return;
     }
-
-    /* Wyświetlanie informacji o liczbie znalezionych plików */
-    (void)sprintf(msg, "Wykryto %d pliki", player.fileCount);
-    oled_putString(1, 30, (uint8_t*)msg, OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-    Timer0_us_Wait(100000U);
-    display_files();
-    if (player.fileCount > 0) {
-        play_wav_file(player.fileList[player.currentTrack]);
+    pos = lib_enter(&t, track);
+    if (pos < 0) {
+        ui_setRow(STATUS_ROW, "Dir err", OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
+        return;
     }
+    list_reload(pos);
 
-	/* Główna pętla programu */
-    while (1) {
-        now = getTicks();
-
-        /* głośność ADC */
-        if ((now - lastADCCheck) >= 200U) {
-            lastADCCheck = now;
-            ADC_StartCmd(LPC_ADC, ADC_START_NOW);
-            while (ADC_ChannelGetStatus(LPC_ADC, ADC_CHANNEL_0, ADC_DATA_DONE) == 0U) {
-                /* czekanie na zakończenie konwersji */
-            }
-            v = (ADC_ChannelGetData(LPC_ADC, ADC_CHANNEL_0) * 100U) / 4095U;
-            volume_diff = (int32_t)v - (int32_t)player.volume;
-            if ((volume_diff > 2) || (volume_diff < -2)) {
-                set_volume(v);
-            }
-        }
+    /* sprawdzenie albo budowa indeksu katalogu w tle */
+    sched_signal(TASK_LIBRARY);
+}
 
-        /* podwójny bufor */
-        if ((player.isPlaying == true) && (player.isPaused == false)) {
-            for (i = 0; i < 2; i++) {
-                if ((player.bufReady[i] == false) && (player.remainingData > 0U)) {
-                    toRead = (player.remainingData > HALF_BUF_SIZE) ? HALF_BUF_SIZE : player.remainingData;
-                    fr = f_read(&player.currentFile, wavBuf[i], toRead, &br);
-                    if ((fr == FR_OK) && (br > 0U)) {
-                        player.remainingData -= br;
-                        player.bufReady[i] = true;
-                    }
-                    else {
-                        stop_wav();
-                    }
-                }
-            }
+/*!
+ *  @brief    Zgłasza bieżący utwór, pozycję, głośność i tryb do zapisu w EEPROM.
+ *
+ *  @side effects:
+ *            Tylko kopiuje stan - zapis wykonuje resume_task() z zadania okresowego.
+ *            Pozycja jest cofnięta o dane czekające w buforach.
+ *            Odtwarzany utwór jest zapisywany ze skrótem ścieżki swojego katalogu,
+ *            także gdy lista pokazuje już inny; bez odtwarzania - zaznaczony utwór.
+ */
+static void save_state(void)
+{
+    ResumeState_t st;
+    LibTrack_t t;
+    uint32_t played;
+
+    if (player.isPlaying == true) {
+        played = player.dataSize - player.remainingData;
+        /* dane w buforach nie zostały jeszcze odtworzone */
+        played = (played > WAV_BUF_SIZE) ? (played - WAV_BUF_SIZE) : 0U;
+        st.track = player.playIndex;
+        st.nameHash = player.playName;
+        st.pathHash = player.playPath;
+    }
+    else {
+        if ((lib_get(player.currentTrack, &t) == false) || ((t.flags & LIB_FLAG_DIR) != 0U)) {
+            return;
         }
+        played = 0U;
+        st.track = (uint16_t)player.currentTrack;
+        st.nameHash = resume_hash(t.name);
+        st.pathHash = lib_pathHash();
+    }
+    st.offset = played & ~(PCM_BYTES_PER_SAMPLE - 1U);
+    st.volume = (uint8_t)player.volume;
+    st.mode = (uint8_t)(player.xfadeS & RESUME_MODE_XFADE_MASK);
+    if (player.view == VIEW_SPECTRUM) {
+        st.mode |= RESUME_MODE_SPECTRUM;
+    }
+    resume_save(&st);
+}
 
-        /* włączenie i wyłączenie odtwarzacza */
-        btnPower = (GPIO_ReadValue(0) & (1UL << 4)) != 0U;
-        if ((btnPower == false) && (lastButtonPower == true)) {
-            player.screenState = !player.screenState;
-            screenNeedsUpdate = true;
+/*!
+ *  @brief    Przywraca stan zapisany w EEPROM przed wyłączeniem zasilania.
+ *
+ *  @returns  Pozycja startu w bajtach danych PCM, 0 gdy brak zapisu albo utworu
+ *  @side effects:
+ *            Ustawia głośność, widok, długość przejścia i player.currentTrack.
+ *            Wchodzi do katalogu zapisanego utworu (szukanego po skrócie ścieżki).
+ *            Utwór jest szukany po skrócie nazwy, gdy lista zmieniła się od zapisu.
+ */
+static uint32_t restore_state(void)
+{
+    ResumeState_t st;
+    LibTrack_t t;
+    int32_t i;
+
+    if (resume_load(&st) == false) {
+        return 0U;
+    }
+
+    set_volume(st.volume);
+    player.xfadeS = st.mode & RESUME_MODE_XFADE_MASK;
+    player.view = ((st.mode & RESUME_MODE_SPECTRUM) != 0U) ? VIEW_SPECTRUM : VIEW_LIST;
+
+    /* katalog utworu; bez indeksu budowany tu do końca, jak przy starcie */
+    if (lib_enterPath(st.pathHash) == true) {
+        while (lib_step() == true) {
         }
+        (void)lib_takeChanged();
+        load_list();
+    }
 
-        if (screenNeedsUpdate == true) {
-            if (player.screenState == false) {
-                oled_clearScreen(OLED_COLOR_BLACK);
-                stop_wav();
+    if ((lib_get((int32_t)st.track, &t) == true) && (resume_hash(t.name) == st.nameHash)) {
+        player.currentTrack = (int32_t)st.track;
+        return st.offset;
+    }
+    /* kolejne rekordy indeksu - 16 na sektor */
+    for (i = 0; lib_get(i, &t) == true; i++) {
+        if (resume_hash(t.name) == st.nameHash) {
+            player.currentTrack = i;
+            return st.offset;
+        }
+    }
+    return 0U;
+}
+
+/*!
+ *  @brief    Wstrzymuje lub wznawia odtwarzanie.
+ *  @param pause
+ *            true - pauza, false - wznowienie
+ *
+ *  @side effects:
+ *            Pauza wygasza wyjście, zatrzymuje Timer1 i usypia tor audio; wznowienie budzi go
+ *            z narastaniem wzmocnienia i zeruje miernik VU.
+ *            Pokazuje stan w wierszu statusu.
+ */
+static void set_pause(bool pause)
+{
+    if (player.isPlaying == false) {
+        return;
+    }
+    if (pause == true) {
+        /* fade_out() nic nie robi przy ustawionej pauzie - flaga dopiero po wygaszeniu */
+        fade_out();
+        TIM_Cmd(LPC_TIM1, DISABLE);
+        player.isPaused = true;
+        power_sleep();
+        save_state();
+        ui_setRow(STATUS_ROW, "Pauza", OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
+    }
+    else {
+        player.isPaused = false;
+        vu_reset();
+        power_wake(getTicks());
+        fade_in();
+        TIM_Cmd(LPC_TIM1, ENABLE);
+        sched_signal(TASK_AUDIO);
+        show_progress();
+    }
+}
+
+/*!
+ *  @brief    Przewija odtwarzany utwór.
+ *  @param seconds
+ *            Przesunięcie w sekundach, ujemne do tyłu
+ *
+ *  @side effects:
+ *            Wygasza wyjście, unieważnia obie połówki bufora (z wyłączonym przerwaniem
+ *            Timer1), zeruje miernik VU i ustawia wskaźnik pliku przez f_lseek (porzucając bufor
+ *            sektora strumienia); bufory doczytuje pętla główna,
+ *            a odtwarzanie rusza z narastaniem.
+ *            Przy błędzie f_lseek zatrzymuje odtwarzanie.
+ */
+static void seek_wav(int32_t seconds)
+{
+    uint32_t bytesPerSec = player.sampleRate * player.numChannels * PCM_BYTES_PER_SAMPLE;
+    int32_t pos;
+
+    if ((player.isPlaying == false) || (bytesPerSec == 0U)) {
+        return;
+    }
+
+    pos = (int32_t)(player.dataSize - player.remainingData) + (seconds * (int32_t)bytesPerSec);
+    if (pos < 0) {
+        pos = 0;
+    }
+    else if (pos > (int32_t)player.dataSize) {
+        pos = (int32_t)player.dataSize;
+    }
+    else {
+        /* w granicach danych */
+    }
+    pos &= ~(int32_t)(PCM_BYTES_PER_SAMPLE - 1U);
+
+    fade_out();
+    next_drop();
+    NVIC_DisableIRQ(TIMER1_IRQn);
+    player.bufReady[0] = false;
+    player.bufReady[1] = false;
+    player.activeBuf = 0U;
+    player.bufPos = 0U;
+    NVIC_EnableIRQ(TIMER1_IRQn);
+    vu_reset();
+
+    if (f_lseek(&player.currentFile, WAV_HEADER_SIZE + (uint32_t)pos) != FR_OK) {
+        stop_wav();
+        ui_setRow(STATUS_ROW, "Seek err", OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
+        return;
+    }
+    sds_attach(&curStream, &player.currentFile);
+    player.remainingData = player.dataSize - (uint32_t)pos;
+    fade_in();
+    sched_signal(TASK_AUDIO);
+    if (player.isPaused == false) {
+        show_progress();
+    }
+}
+
+/*!
+ *  @brief    Wykonuje akcję przypisaną do zdarzenia wejścia.
+ *  @param ev
+ *            Zdarzenie z kolejki input_get()
+ *
+ *  @returns  true jeśli zmieniono stan ekranu (przycisk zasilania)
+ *  @side effects:
+ *            Enkoder - zaznaczenie na liście; góra/dół - poprzedni/następny utwór;
+ *            lewo/prawo - przewijanie; środek - odtworzenie zaznaczonego utworu,
+ *            wejście do katalogu albo pauza, przytrzymany środek - zmiana widoku
+ *            po puszczeniu; obrót enkodera z wciśniętym środkiem - długość przejścia
+ *            między utworami (wtedy puszczenie środka nie wykonuje innej akcji).
+ *            Przy wyłączonym ekranie obsługiwany jest tylko przycisk zasilania.
+ */
+static bool handle_input(const InputEvent_t* ev)
+{
+    bool step = (ev->type == INPUT_EV_PRESS) || (ev->type == INPUT_EV_REPEAT);
+
+    if ((ev->key == INPUT_KEY_POWER) && (ev->type == INPUT_EV_PRESS)) {
+        player.screenState = !player.screenState;
+        /* puszczenie środka przy wyłączonym ekranie nie dotrze do obsługi */
+        centerHeld = false;
+        return true;
+    }
+    if (player.screenState == false) {
+        return false;
+    }
+
+    switch (ev->key) {
+    case 0U:
+        if ((ev->type == INPUT_EV_ROTATE) && (centerHeld == true)) {
+            centerTurned = true;
+            set_xfade(ev->value);
+        }
+        else if (ev->type == INPUT_EV_ROTATE) {
+            move_selection(ev->value);
+        }
+        else {
+            /* enkoder zgłasza tylko obrót */
+        }
+        break;
+    case INPUT_KEY_UP:
+        if (step == true) {
+            play_track(player.currentTrack - 1);
+        }
+        break;
+    case INPUT_KEY_DOWN:
+        if (step == true) {
+            play_track(player.currentTrack + 1);
+        }
+        break;
+    case INPUT_KEY_LEFT:
+        if (step == true) {
+            seek_wav(-SEEK_STEP_S);
+        }
+        break;
+    case INPUT_KEY_RIGHT:
+        if (step == true) {
+            seek_wav(SEEK_STEP_S);
+        }
+        break;
+    case INPUT_KEY_CENTER:
+        if (ev->type == INPUT_EV_LONG) {
+            centerLong = true;
+        }
+        else if (ev->type == INPUT_EV_PRESS) {
+            centerLong = false;
+            centerHeld = true;
+            centerTurned = false;
+        }
+        else if (ev->type == INPUT_EV_RELEASE) {
+            centerHeld = false;
+            if (centerTurned == true) {
+                /* puszczenie po ustawieniu długości przejścia */
+            }
+            else if (centerLong == true) {
+                set_view((player.view == VIEW_LIST) ? VIEW_SPECTRUM : VIEW_LIST);
+            }
+            /* krótkie wciśnięcie: pauza dla odtwarzanego, start dla innego utworu */
+            else if ((player.isPlaying == true) && (player.playingTrack == player.currentTrack)) {
+                set_pause(!player.isPaused);
             }
             else {
-                display_files();
-                if (player.fileCount > 0) {
-                    play_wav_file(player.fileList[player.currentTrack]);
+                open_entry(player.currentTrack);
+            }
+        }
+        else {
+            /* środek nie ma autopowtarzania */
+        }
+        break;
+    default:
+        break;
+    }
+    return false;
+}
+
+/*!
+ *  @brief    Ustawia linijkę LED na zadany poziom.
+ *  @param level
+ *            Poziom w 1/256 diody, 0-VU_LEVEL_MAX
+ *  @param peakLed
+ *            Dioda wskaźnika szczytu albo VU_NO_PEAK
+ *
+ *  @side effects:
+ *            Proporcjonalnie włącza LED od dołu do góry. Ułamek ostatniej diody
+ *            pokazuje jej jasność (PWM0 sterownika PCA9532).
+ *            Zmienia tylko rejestry cienia sterownika - zapis po I2C wysyła
+ *            pca9532_flush() raz na ramkę, i to tylko zmienione rejestry.
+ */
+static void led_bar_show(uint32_t level, uint8_t peakLed)
+{
+    uint32_t full;
+    uint8_t frac;
+    uint16_t ledOn;
+
+    if (level > VU_LEVEL_MAX) {
+        level = VU_LEVEL_MAX;
+    }
+    full = level >> 8;
+    frac = (uint8_t)(level & 0xFFU);
+
+    ledOn = (uint16_t)((1U << full) - 1U);
+    if (peakLed < LED_BAR_LEDS) {
+        ledOn |= (uint16_t)(1U << peakLed);
+    }
+    pca9532_setLeds(ledOn, (uint16_t)(LED_BAR_MASK & ~ledOn));
+
+    /* dioda ułamkowa, chyba że świeci na niej wskaźnik szczytu */
+    if ((frac != 0U) && (full < LED_BAR_LEDS) && ((ledOn & (1U << full)) == 0U)) {
+        pca9532_setBlink0Pwm(frac);
+        pca9532_setBlink0Leds((uint16_t)(1U << full));
+    }
+}
+
+/*!
+ *  @brief    Ustawia linijkę LED zgodnie z poziomem głośności.
+ *  @param volume
+ *            Poziom głośności w zakresie 0-100
+ *
+ *  @side effects:
+ *            Zmienia rejestry cienia sterownika PCA9532.
+ */
+static void led_bar_set(uint8_t volume) {
+    if (volume > VOLUME_MAX) {
+        volume = VOLUME_MAX;
+    }
+    led_bar_show(((uint32_t)volume * VU_LEVEL_MAX) / VOLUME_MAX, VU_NO_PEAK);
+}
+
+/*!
+ *  @brief    Ramka linijki LED: wskazanie VU podczas odtwarzania, poza nim głośność.
+ *  @param now
+ *            Aktualny czas w milisekundach
+ *
+ *  @side effects:
+ *            Przez VOLUME_SHOW_MS po zmianie głośności linijka pokazuje głośność.
+ *            Wysyła zmienione rejestry sterownika i zapisuje koszt ramki w vu_stats().
+ */
+static void led_frame(uint32_t now)
+{
+    VuFrame_t frame;
+    pca9532_stats_t before;
+    pca9532_stats_t after;
+    VuStats_t* vs = vu_stats();
+
+    if ((player.isPlaying == true) && (player.isPaused == false)
+        && ((int32_t)(now - volumeShowUntil) >= 0)) {
+        if (vu_frame(now, &frame) == true) {
+            led_bar_show(frame.level, frame.peakLed);
+        }
+        ledShowsVu = true;
+    }
+    else if (ledShowsVu == true) {
+        ledShowsVu = false;
+        led_bar_set((uint8_t)player.volume);
+    }
+    else {
+        /* linijka pokazuje już głośność */
+    }
+
+    pca9532_getStats(&before);
+    pca9532_flush();
+    pca9532_getStats(&after);
+    vs->i2cBytes = after.bytes - before.bytes;
+    if (vs->i2cBytes > vs->i2cMaxBytes) {
+        vs->i2cMaxBytes = vs->i2cBytes;
+    }
+}
+
+
+/*!
+ *  @brief    Wyświetla listę plików WAV na ekranie OLED z oznaczeniem aktualnie wybranego utworu.
+ * 
+ *  @side effects:
+ *            Ustawia wiersze listy przez screen_list(), nazwy z okna biblioteki -
+ *            przesunięcie o wiersz doczytuje jeden rekord.
+ *            Jeśli ekran jest wyłączony (player.screenState == false) albo aktywny jest inny widok,
+ *            funkcja kończy działanie wcześniej.
+ */
+static void display_files(void)
+{
+    /* Sprawdź czy ekran jest włączony i czy lista jest widoczna */
+    if ((player.screenState == false) || (player.view != VIEW_LIST)) {
+        return;
+    }
+
+    screen_list(player.currentTrack, lib_name);
+}
+
+/*!
+ *  @brief    Sprawdza czy któraś połówka bufora audio czeka na doczytanie z karty.
+ *
+ *  @returns  true jeśli pętla główna powinna najpierw uzupełnić bufor
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static bool audio_needs_refill(void)
+{
+    return (player.isPlaying == true) && (player.isPaused == false) && (player.remainingData > 0U)
+        && ((player.bufReady[0] == false) || (player.bufReady[1] == false));
+}
+
+/*!
+ *  @brief    Wykonuje jeden ograniczony krok rysowania interfejsu.
+ *
+ *  @side effects:
+ *            Nie robi nic, gdy któraś połówka bufora audio jest pusta - odczyt z karty ma pierwszeństwo.
+ *            Aktualizuje statystyki czasu kroków i liczby bajtów wysłanych przez SPI w uiStats.
+ */
+static void ui_step(void)
+{
+    uint32_t start;
+    uint32_t elapsed;
+    oled_stats_t spi;
+
+    if ((ui_pending() == false) || (audio_needs_refill() == true)) {
+        return;
+    }
+
+    oled_resetStats();
+    start = getMicros();
+    if (ui_task() == true) {
+        elapsed = getMicros() - start;
+        oled_getStats(&spi);
+        uiStats.slices++;
+        uiStats.lastSliceUs = elapsed;
+        uiStats.lastSliceBytes = spi.bytes;
+        if (elapsed > uiStats.maxSliceUs) {
+            uiStats.maxSliceUs = elapsed;
+        }
+        if (spi.bytes > uiStats.maxSliceBytes) {
+            uiStats.maxSliceBytes = spi.bytes;
+        }
+    }
+}
+
+/*!
+ *  @brief    Aktualizuje czas odtwarzania i pasek postępu.
+ *
+ *  @side effects:
+ *            Ustawia wiersz statusu i pasek postępu przez screen_progress().
+ */
+static void show_progress(void)
+{
+    screen_progress(player.dataSize - player.remainingData, player.dataSize,
+        player.sampleRate * player.numChannels * PCM_BYTES_PER_SAMPLE);
+}
+
+/*!
+ *  @brief    Przełącza widok w górnej części ekranu.
+ *  @param view
+ *            Nowy widok: lista utworów albo analizator widma
+ *
+ *  @side effects:
+ *            Przy wejściu do analizatora czyści wiersze listy (ui_task), słupki
+ *            są rysowane dopiero po ich wyczyszczeniu.
+ *            Przy powrocie rysuje ponownie listę utworów.
+ */
+static void set_view(ViewMode view)
+{
+    uint8_t i;
+
+    player.view = view;
+    if (view == VIEW_SPECTRUM) {
+        for (i = 0U; i < LIST_ROWS; i++) {
+            ui_setRow(i, "", OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
+        }
+        spectrum_reset();
+    }
+    else {
+        /* słupki były rysowane z pominięciem modelu ekranu */
+        ui_invalidate(0U, LIST_ROWS - 1U);
+        display_files();
+    }
+}
+
+/*!
+ *  @brief    Ustawia poziom głośności i aktualizuje linijkę diodową.
+ *  @param vol
+ *            Poziom głośności w zakresie 0-100. Wartości powyżej 100 są ograniczane do 100.
+ * 
+ *  @side effects:
+ *            Modyfikuje player.volume.
+ *            Zmienia krok wzmacniacza LM4811, a dostrojenie cyfrowe próbek
+ *            przechodzi do nowej wartości rampą przez jeden blok.
+ */
+static void set_volume(uint32_t vol)
+{
+    uint32_t limited_vol = vol;
+
+	/* Ograniczenie głośności do zakresu 0-100 */
+    if (limited_vol > VOLUME_MAX) {
+        limited_vol = VOLUME_MAX;
+    }
+
+    player.volume = limited_vol;
+    outTrim = amp_setVolume((uint8_t)limited_vol);
+    gain_ramp(outTrim, VOLUME_RAMP_SAMPLES);
+    led_bar_set((uint8_t)player.volume);
+}
+
+/*!
+ *  @brief    Ustawia rampę wzmocnienia toru próbek.
+ *  @param target
+ *            Docelowe wzmocnienie w Q15
+ *  @param samples
+ *            Długość rampy w próbkach, 0 - zmiana natychmiastowa
+ *
+ *  @side effects:
+ *            Zmienia stan rampy z wyłączonym przerwaniem Timer1. Rampa postępuje
+ *            tylko przy wysyłanych próbkach, więc przy zatrzymanym timerze czeka.
+ */
+static void gain_ramp(int32_t target, uint32_t samples)
+{
+    NVIC_DisableIRQ(TIMER1_IRQn);
+    gainTarget = target;
+    if (samples == 0U) {
+        outGain = target;
+        rampLeft = 0U;
+    }
+    else {
+        gainStep = (target - outGain) / (int32_t)samples;
+        rampLeft = samples;
+    }
+    NVIC_EnableIRQ(TIMER1_IRQn);
+}
+
+/*!
+ *  @brief    Zaczyna narastanie wzmocnienia od ciszy do bieżącej głośności.
+ *
+ *  @side effects:
+ *            Wywoływana przed uruchomieniem Timer1 albo po unieważnieniu buforów.
+ */
+static void fade_in(void)
+{
+    gain_ramp(0, 0U);
+    gain_ramp(outTrim, FADE_SAMPLES);
+}
+
+/*!
+ *  @brief    Wygasza wyjście do ciszy przed zatrzymaniem albo zmianą pozycji.
+ *
+ *  @side effects:
+ *            Czeka aż przerwanie Timer1 wyśle próbki wygaszania, najwyżej
+ *            FADE_TIMEOUT_MS (gdy w buforze zabraknie danych rampa stoi).
+ *            Po wygaszeniu DAC stoi na wartości środkowej.
+ */
+static void fade_out(void)
+{
+    uint32_t start = getTicks();
+
+    if ((player.isPlaying == false) || (player.isPaused == true)) {
+        return;
+    }
+    gain_ramp(0, FADE_SAMPLES);
+    while ((rampLeft != 0U) && ((getTicks() - start) < FADE_TIMEOUT_MS)) {
+        __WFI();
+    }
+}
+
+/*!
+ *  @brief    Zadanie doczytywania bufora audio, budzone przez Timer1 po zużyciu połówki.
+ *
+ *  @side effects:
+ *            Uzupełnia puste połówki bufora z karty SD i przekazuje je do miernika VU
+ *            i analizatora, potem doczytuje jeden sektor strumienia z wyprzedzeniem.
+ *            Przed końcem utworu otwiera następny, by odtwarzanie przeszło bez przerwy.
+ *            Po wyczerpaniu danych i odtworzeniu buforów kończy odtwarzanie.
+ */
+static void task_audio(void)
+{
+    uint32_t len;
+    int32_t i;
+
+    if ((player.isPlaying == false) || (player.isPaused == true)) {
+        return;
+    }
+
+    /* podwójny bufor */
+    for (i = 0; i < 2; i++) {
+        if ((player.bufReady[i] == false) && ((player.remainingData > 0U) || (player.nextReady == true))) {
+            if (fill_half(wavBuf[i], &len) == false) {
+                stop_wav();
+                return;
+            }
+            if (len > 0U) {
+                player.bufReady[i] = true;
+                vu_feed(wavBuf[i], len);
+                if (player.view == VIEW_SPECTRUM) {
+                    spectrum_feed(wavBuf[i], len);
                 }
             }
-            screenNeedsUpdate = false;
         }
-        lastButtonPower = btnPower;
+    }
+
+    /* obie połówki pełne: jeden sektor z wyprzedzeniem, żeby opóźnienie karty przy
+       następnym doczytaniu nie opóźniło połówki; w przejściu dla strumienia z mniejszym zapasem */
+    if ((player.bufReady[0] == true) && (player.bufReady[1] == true)) {
+        if ((player.xfading == true) && (sds_buffered(&nextStream) < sds_buffered(&curStream))) {
+            (void)sds_topUp(&nextStream);
+        }
+        else {
+            (void)sds_topUp(&curStream);
+        }
+    }
+
+    /* następny utwór otwierany przed przejściem, gdy obie połówki są pełne - jest zapas na f_open */
+    if ((player.remainingData <= (xfade_bytes() + PREFETCH_BYTES))
+        && (player.bufReady[0] == true) && (player.bufReady[1] == true)) {
+        prefetch_next();
+    }
+
+    /* zakończenie odtwarzania dźwięku */
+    if ((player.remainingData == 0U) && (player.nextReady == false)
+        && (player.bufReady[0] == false) && (player.bufReady[1] == false)) {
+        show_progress();
+        /* dane się skończyły - nie ma próbek do wygaszenia */
+        gain_ramp(0, 0U);
+        stop_wav();
+        save_state();
+        ui_setRow(STATUS_ROW, "Zakonczono", OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
+    }
+}
+
+/*!
+ *  @brief    Zadanie obsługi zdarzeń wejścia zebranych w SysTick_Handler.
+ *
+ *  @side effects:
+ *            Opróżnia kolejkę zdarzeń i wykonuje przypisane akcje.
+ *            Po przełączeniu zasilania ekranu czyści go i wstrzymuje odtwarzanie
+ *            z zachowaniem pliku, pozycji i buforów, albo je wznawia.
+ */
+static void task_input(void)
+{
+    InputEvent_t ev;
+    bool screenNeedsUpdate = false;
+
+    while (input_get(&ev) == true) {
+        if (handle_input(&ev) == true) {
+            screenNeedsUpdate = true;
+        }
+        input_dispatched(&ev, getTicks());
+    }
+
+    if (screenNeedsUpdate == true) {
+        if (player.screenState == false) {
+            /* pauza z zachowaniem otwartego pliku, pozycji i buforów */
+            player.powerPaused = (player.isPlaying == true) && (player.isPaused == false);
+            if (player.powerPaused == true) {
+                set_pause(true);
+            }
+            ui_clear(OLED_COLOR_BLACK);
+        }
+        else {
+            ui_clear(OLED_COLOR_WHITE);
+            set_view(player.view);
+            if (player.powerPaused == true) {
+                /* wznowienie z pełnych buforów, bez ponownego otwierania pliku */
+                player.powerPaused = false;
+                set_pause(false);
+            }
+            else if (player.isPlaying == true) {
+                /* pauza ustawiona przed wyłączeniem ekranu zostaje */
+                show_progress();
+                ui_setRow(STATUS_ROW, "Pauza", OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
+            }
+            else {
+                play_track(player.currentTrack);
+            }
+        }
+    }
+}
+
+/*!
+ *  @brief    Zadanie głośności, budzone przez ADC_IRQHandler po zmianie poziomu potencjometru.
+ *
+ *  @side effects:
+ *            Ustawia głośność i linijkę LED na przefiltrowany poziom; linijka
+ *            pokazuje głośność przez VOLUME_SHOW_MS zamiast miernika VU.
+ */
+static void task_volume(void)
+{
+    volumeShowUntil = getTicks() + VOLUME_SHOW_MS;
+    set_volume(pot_level());
+}
+
+/*!
+ *  @brief    Zadanie okresowe, budzone co 1 ms przez SysTick.
+ *
+ *  @side effects:
+ *            Raz na sekundę aktualizuje czas i pasek postępu.
+ *            Co LED_FRAME_MS odświeża linijkę LED (miernik VU albo głośność).
+ *            Prowadzi narastanie wzmocnienia po wybudzeniu toru audio.
+ *            Co RESUME_PERIOD_MS zgłasza stan odtwarzania do zapisu w EEPROM.
+ *            Budzi zadanie interfejsu gdy jest coś do narysowania albo aktywny jest analizator.
+ */
+static void task_tick(void)
+{
+    uint32_t now = getTicks();
+
+    power_tick(now);
+
+    /* stan do EEPROM: okresowo w trakcie odtwarzania, zapis jednej strony na krok */
+    if ((player.isPlaying == true) && (player.isPaused == false)
+        && ((now - lastStateSave) >= RESUME_PERIOD_MS)) {
+        lastStateSave = now;
+        save_state();
+    }
+    resume_task(now);
+
+    /* czas i pasek postępu raz na sekundę */
+    if ((player.isPlaying == true) && (player.isPaused == false)
+        && ((now - lastProgress) >= PROGRESS_UPDATE_MS)) {
+        lastProgress = now;
+        show_progress();
+    }
+
+    /* linijka LED: VU albo głośność, zmiany z całej ramki jednym zapisem */
+    if ((now - lastLedFrame) >= LED_FRAME_MS) {
+        lastLedFrame = now;
+        led_frame(now);
+    }
+
+    if ((ui_pending() == true) || ((player.view == VIEW_SPECTRUM) && (player.screenState == true))) {
+        sched_signal(TASK_UI);
+    }
+}
+
+/*!
+ *  @brief    Zadanie interfejsu: jeden krok rysowania albo jeden krok analizatora widma.
+ *
+ *  @side effects:
+ *            Budzi się ponownie, dopóki w modelu ekranu są nienarysowane wiersze.
+ *            Analizator działa tylko gdy ekran jest już narysowany i bufory pełne.
+ */
+static void task_ui(void)
+{
+    /* rysowanie interfejsu po kawałku, po obsłudze bufora audio */
+    ui_step();
+
+    if ((player.view == VIEW_SPECTRUM) && (player.screenState == true)
+        && (ui_pending() == false) && (audio_needs_refill() == false)) {
+        (void)spectrum_task(getTicks());
+    }
+
+    if (ui_pending() == true) {
+        sched_signal(TASK_UI);
+    }
+}
+
+/*!
+ *  @brief    Jeden krok startu: inicjalizacja karty SD, ekranu i wczytanie listy utworów.
+ *
+ *  @returns  true jeśli krok coś wykonał, false gdy czeka na następny takt SysTick
+ *  @side effects:
+ *            Karta jest odpytywana ACMD41 raz na milisekundę, a ekran inicjalizowany
+ *            pomiędzy odpytaniami. Katalog jest czytany po jednym wpisie na krok.
+ *            Zapisuje czasy etapów w bootTrace.
+ */
+static bool boot_step(void)
+{
+    DSTATUS stat;
+
+    /* ekran w czasie, gdy karta wychodzi ze stanu bezczynności */
+    if ((bootOled == false) && (bootState != BOOT_SD_DETECT)) {
+        boot_oled();
+        return true;
+    }
+
+    switch (bootState) {
+    case BOOT_SD_DETECT:
+        if (getTicks() < BOOT_SD_DETECT_MS) {
+            return false;
+        }
+        (void)disk_init_start(0);
+        bootTrace.sdStartUs = getMicros();
+        bootLastPoll = getTicks();
+        bootState = BOOT_SD_INIT;
+        break;
+
+    case BOOT_SD_INIT:
+        if (getTicks() == bootLastPoll) {
+            return false;
+        }
+        bootLastPoll = getTicks();
+        bootTrace.sdPolls++;
+        if (disk_init_poll(0) == 0U) {
+            break;
+        }
+        bootTrace.sdReadyUs = getMicros();
+
+        /* Sprawdzenie statusu karty SD */
+        stat = disk_status(0);
+        if ((stat & STA_NOINIT) != 0U) {
+            oled_putString(1, 19, (uint8_t*)"nie init.", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+        }
+        if ((stat & STA_NODISK) != 0U) {
+            oled_putString(1, 28, (uint8_t*)"brak karty", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+        }
+        bootState = BOOT_MOUNT;
+        break;
+
+    case BOOT_MOUNT:
+        oled_clearScreen(OLED_COLOR_WHITE);
+
+        /* Montowanie karty SD i inicjalizacja FAT */
+        if (f_mount(0, &Fatfs[0]) != FR_OK) {
+            oled_putString(1, 20, (uint8_t*)"err. mont. SD", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+            bootState = BOOT_FAIL;
+            break;
+        }
+        oled_putString(1, 20, (uint8_t*)"SD OK", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+        bootTrace.mountUs = getMicros();
+
+        /* Lista utworów z indeksu na karcie; katalog jest sprawdzany dopiero w tle */
+        lib_init(getMicros);
+        if (lib_load() == true) {
+            boot_scanDone();
+            break;
+        }
+
+        /* Brak indeksu albo nieczytelny - budowa przed startem odtwarzania */
+        lib_rebuild();
+        if (lib_busy() == false) {
+            oled_putString(1, 30, (uint8_t*)"err. otw. dir", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+            bootState = BOOT_FAIL;
+            break;
+        }
+        bootState = BOOT_SCAN;
+        break;
+
+    case BOOT_SCAN:
+        if (lib_step() == false) {
+            (void)lib_takeChanged();
+            boot_scanDone();
+        }
+        break;
+
+    default:
+        break;
+    }
+    return true;
+}
+
+/*!
+ *  @brief    Inicjalizuje ekran i pokazuje napis startowy.
+ *
+ *  @side effects:
+ *            Korzysta z SSP1 między odpytaniami karty SD (karta jest wtedy odznaczona).
+ */
+static void boot_oled(void)
+{
+    oled_init();
+    oled_clearScreen(OLED_COLOR_WHITE);
+    oled_putString(1, 1, (uint8_t*)"WAV Player", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+    oled_putString(1, 10, (uint8_t*)"Init...", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+    bootOled = true;
+    bootTrace.oledUs = getMicros();
+}
+
+/*!
+ *  @brief    Kończy wczytywanie listy utworów i pokazuje ich liczbę.
+ *
+ *  @side effects:
+ *            Wypełnia listę z indeksu i kończy start (BOOT_DONE). Gdy indeksu
+ *            nie dało się zapisać, lista pochodzi wprost z katalogu i pokazywany
+ *            jest błąd zapisu.
+ */
+static void boot_scanDone(void)
+{
+    char msg[32];
+
+    load_list();
+
+    /* Wyświetlanie informacji o liczbie znalezionych plików */
+    (void)sprintf(msg, "Wykryto %d pliki", (int)lib_count());
+    oled_putString(1, 30, (uint8_t*)msg, OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+    if (lib_readOnly() == true) {
+        oled_putString(1, 40, (uint8_t*)"err. zap. idx", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+    }
+    bootTrace.scanUs = getMicros();
+    bootState = BOOT_DONE;
+}
+
+/*!
+ *  @brief    Ustawia długość listy utworów według indeksu.
+ *
+ *  @side effects:
+ *            Zmienia player.fileCount; nazwy są czytane na żądanie przez lib_name().
+ */
+static void load_list(void)
+{
+    player.fileCount = lib_count();
+}
+
+/*!
+ *  @brief    Zadanie biblioteki: jeden krok sprawdzania albo przebudowy indeksu.
+ *
+ *  @side effects:
+ *            Budzi się ponownie do końca przejścia katalogu. Po przebudowie
+ *            wczytuje listę od nowa; lista bez indeksu (pełna karta, błąd
+ *            zapisu) jest zgłaszana w wierszu statusu.
+ */
+static void task_library(void)
+{
+    if (lib_step() == true) {
+        sched_signal(TASK_LIBRARY);
+    }
+    if (lib_takeChanged() == true) {
+        list_reload(-1);
+        if (lib_readOnly() == true) {
+            ui_setRow(STATUS_ROW, "Idx err", OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
+        }
+    }
+}
+
+/*!
+ *  @brief    Wczytuje listę po zmianie indeksu albo katalogu.
+ *  @param select
+ *            Nowe zaznaczenie, -1 - odtwarzany utwór albo dotychczasowe
+ *
+ *  @side effects:
+ *            Odnajduje odtwarzany utwór po pierwszym klastrze, w pobliżu jego
+ *            poprzedniego numeru albo nowego zaznaczenia; poza bieżącym
+ *            katalogiem utwór gra dalej bez numeru na liście.
+ */
+static void list_reload(int32_t select)
+{
+    int32_t near = (select >= 0) ? select : player.playingTrack;
+
+    if (near < 0) {
+        near = player.currentTrack;
+    }
+
+    load_list();
+
+    /* numery utworów z nowej listy; otwarty zawczasu następny utwór mógł się zmienić */
+    if (player.xfading == false) {
+        next_drop();
+    }
+    player.playingTrack = ((player.isPlaying == true) && (near >= 0))
+        ? lib_findCluster(player.currentFile.org_clust, near) : -1;
+    if (select >= 0) {
+        player.currentTrack = select;
+    }
+    else if (player.playingTrack >= 0) {
+        player.currentTrack = player.playingTrack;
+    }
+    else if (player.currentTrack >= player.fileCount) {
+        player.currentTrack = (player.fileCount > 0) ? (player.fileCount - 1) : 0;
+    }
+    else {
+        /* zaznaczenie bez zmian */
+    }
+    if (player.xfading == true) {
+        /* przejście trwa dalej, zmienia się tylko numer narastającego utworu */
+        player.nextTrack = (player.playingTrack >= 0) ? (player.playingTrack + 1) : -1;
+    }
+    display_files();
+}
 
-        /* zakończenie odtwarzania dźwięku */
-        if ((player.isPlaying == true) && (player.isPaused == false) && (player.remainingData == 0U)
-            && (player.bufReady[0] == false) && (player.bufReady[1] == false)) {
-            stop_wav();
-            oled_putString(1, 45, (uint8_t*)"Zakonczono", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+/*!
+ *  @brief    Główna funkcja programu - inicjalizuje system i obsługuje pętlę główną odtwarzacza WAV.
+ *  @returns  Kod zakończenia programu: 1 w przypadku błędu, 0 w przypadku normalnego zakończenia
+ * 
+ *  @side effects:
+ *            Inicjalizuje wszystkie peryferia.
+ *            Montuje, weryfikuje kartę SD i skanuje pliki WAV.
+ *            Uruchamia planistę zadań obsługujących odtwarzanie muzyki i interfejs użytkownika.
+ *            Wyświetla informacje na ekranie OLED.
+ */
+int main(void) {
+    uint32_t resumeOffset;
+
+    SystemInit();
+    input_init();
+	/* Inicjalizacja zegara systemowego 1 ms*/
+    SysTick_Config(SystemCoreClock / 1000U);
+    power_init(getMicros);
+
+    init_ssp();
+    init_i2c();
+    init_adc();
+    button_init();
+    rotary_init();
+    init_dac();
+    init_Timer();
+    /* tor audio uśpiony do pierwszego odtwarzania */
+    power_sleep();
+	pca9532_init();
+    /* PWM0 152 Hz - migotanie niewidoczne, wypełnienie ustala jasność */
+    pca9532_setBlink0Period(0U);
+    pca9532_setDeferred(1U);
+    joystick_init();
+
+    /* Ustawienie początkowego poziomu głośności */
+    set_volume(50U);
+    led_bar_set((uint8_t)player.volume);
+
+    /* Karta SD, ekran i lista utworów przeplatane krokami zamiast stałych opóźnień;
+       rdzeń śpi do następnego przerwania gdy żaden krok nie jest gotowy */
+    while (bootState < BOOT_DONE) {
+        if (boot_step() == false) {
+            __WFI();
         }
     }
+    if (bootState == BOOT_FAIL) {
+        return 1;
+    }
+
+    ui_init();
+    spectrum_init(getMicros);
+    vu_init(getMicros);
+    xfade_init(getMicros);
+
+    /* Wznowienie od utworu i pozycji zapisanych przed wyłączeniem */
+    resumeOffset = restore_state();
+    set_view(player.view);
+    play_track_from(player.currentTrack, resumeOffset);
+
+    /* Zadania uruchamiane przez przerwania, rdzeń śpi gdy nic nie czeka */
+    sched_init(getMicros);
+    sched_add(TASK_AUDIO, task_audio);
+    sched_add(TASK_INPUT, task_input);
+    sched_add(TASK_VOLUME, task_volume);
+    sched_add(TASK_TICK, task_tick);
+    sched_add(TASK_UI, task_ui);
+    sched_add(TASK_LIBRARY, task_library);
+    sched_signal(TASK_AUDIO);
+    sched_signal(TASK_VOLUME);
+
+    /* zmiany na karcie od zbudowania indeksu - przejście katalogu w tle */
+    lib_verify();
+    sched_signal(TASK_LIBRARY);
+    sched_run();
+
+    return 0;
 }
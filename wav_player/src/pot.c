@@ -0,0 +1,132 @@
+#include "pot.h"
+
+#define ONE_Q (1UL << POT_FRAC_BITS)
+
+/* Połowa kroku poziomu plus histereza, w Q4 */
+#define SWITCH_Q ((((POT_RAW_MAX * ONE_Q) / POT_LEVEL_MAX) / 2U) + (POT_HYSTERESIS_RAW * ONE_Q))
+
+static uint16_t last[3];
+static uint8_t count = 0U;
+static uint32_t acc = 0U;
+static volatile uint8_t level = 0U;
+
+static PotStats_t stats;
+
+/*!
+ *  @brief    Mediana z trzech próbek, usuwa pojedyncze szpilki.
+ *
+ *  @returns  Wartość środkowa
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static uint16_t median3(uint16_t a, uint16_t b, uint16_t c)
+{
+    if (a > b) {
+        uint16_t t = a;
+        a = b;
+        b = t;
+    }
+    if (b > c) {
+        b = c;
+    }
+    return (a > b) ? a : b;
+}
+
+/*!
+ *  @brief    Inicjalizuje filtr potencjometru.
+ *
+ *  @side effects:
+ *            Pierwsza próbka po inicjalizacji ustawia filtr i poziom bez opóźnienia.
+ */
+void pot_init(void)
+{
+    count = 0U;
+    acc = 0U;
+    level = 0U;
+    stats.samples = 0U;
+    stats.changes = 0U;
+    stats.raw = 0U;
+    stats.filtered = 0U;
+}
+
+/*!
+ *  @brief    Przetwarza próbkę ADC, wywoływana z przerwania przetwornika.
+ *  @param raw
+ *            Wynik konwersji 0-4095
+ *
+ *  @returns  true jeśli poziom głośności się zmienił
+ *  @side effects:
+ *            Mediana z trzech próbek, potem filtr wykładniczy. Poziom zmienia się
+ *            dopiero gdy wyjście filtru odejdzie od środka bieżącego poziomu o pół
+ *            kroku plus histerezę, więc szum potencjometru nie przełącza go w kółko.
+ */
+bool pot_feed(uint16_t raw)
+{
+    uint16_t x;
+    uint32_t center;
+    uint32_t diff;
+    uint8_t next;
+
+    stats.samples++;
+    stats.raw = raw;
+
+    if (count == 0U) {
+        last[0] = raw;
+        last[1] = raw;
+        count = 1U;
+        acc = (uint32_t)raw << POT_FRAC_BITS;
+        level = (uint8_t)((((uint32_t)raw * POT_LEVEL_MAX) + (POT_RAW_MAX / 2U)) / POT_RAW_MAX);
+        stats.filtered = raw;
+        stats.changes++;
+        return true;
+    }
+
+    x = median3(last[0], last[1], raw);
+    last[0] = last[1];
+    last[1] = raw;
+
+    /* acc += (x - acc) / 2^shift, w Q4 */
+    acc = acc + (((uint32_t)x << POT_FRAC_BITS) >> POT_EMA_SHIFT) - (acc >> POT_EMA_SHIFT);
+    stats.filtered = (uint16_t)(acc >> POT_FRAC_BITS);
+
+    center = ((uint32_t)level * POT_RAW_MAX * ONE_Q) / POT_LEVEL_MAX;
+    diff = (acc > center) ? (acc - center) : (center - acc);
+    if (diff <= SWITCH_Q) {
+        return false;
+    }
+
+    next = (uint8_t)(((acc * POT_LEVEL_MAX) + ((POT_RAW_MAX * ONE_Q) / 2U)) / (POT_RAW_MAX * ONE_Q));
+    if (next > POT_LEVEL_MAX) {
+        next = POT_LEVEL_MAX;
+    }
+    if (next == level) {
+        return false;
+    }
+    level = next;
+    stats.changes++;
+    return true;
+}
+
+/*!
+ *  @brief    Zwraca przefiltrowany poziom potencjometru.
+ *
+ *  @returns  Poziom 0-POT_LEVEL_MAX
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+uint8_t pot_level(void)
+{
+    return level;
+}
+
+/*!
+ *  @brief    Zwraca statystyki filtru.
+ *
+ *  @returns  Wskaźnik na statystyki
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+const PotStats_t* pot_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,31 @@
+#ifndef __POT_H
+#define __POT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Zakres przetwornika i poziomów głośności */
+#define POT_RAW_MAX 4095U
+#define POT_LEVEL_MAX 100U
+
+/* Filtr wykładniczy: alfa = 1/2^POT_EMA_SHIFT, stan w Q4 */
+#define POT_EMA_SHIFT 3U
+#define POT_FRAC_BITS 4U
+
+/* Histereza ponad połowę kroku poziomu, w jednostkach surowych ADC */
+#define POT_HYSTERESIS_RAW 12U
+
+/* Statystyki do odczytu debuggerem */
+typedef struct {
+    uint32_t samples;
+    uint32_t changes;
+    uint16_t raw;       /* ostatnia próbka */
+    uint16_t filtered;  /* wyjście filtru */
+} PotStats_t;
+
+void pot_init(void);
+bool pot_feed(uint16_t raw);
+uint8_t pot_level(void);
+const PotStats_t* pot_stats(void);
+
+#endif /* __POT_H */
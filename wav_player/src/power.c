@@ -0,0 +1,145 @@
+#include "lpc17xx_clkpwr.h"
+#include "lpc17xx_dac.h"
+
+#include "power.h"
+#include "amp.h"
+
+#define POWER_DAC_MIDDLE 512U
+
+/* Peryferia włączone po resecie, których odtwarzacz nie używa */
+#define POWER_UNUSED_PCONP (CLKPWR_PCONP_PCUART0 | CLKPWR_PCONP_PCUART1 | CLKPWR_PCONP_PCPWM1 | \
+                            CLKPWR_PCONP_PCI2C0 | CLKPWR_PCONP_PCSPI | CLKPWR_PCONP_PCI2C1 | \
+                            CLKPWR_PCONP_PCSSP0)
+
+static uint32_t (*getUs)(void) = 0;
+
+static bool asleep = false;
+static uint32_t rampStartMs = 0U;
+
+static PowerStats_t stats;
+
+/*!
+ *  @brief    Inicjalizuje zarządzanie zasilaniem toru audio.
+ *  @param clockUs
+ *            Funkcja zwracająca czas w mikrosekundach (pomiar wybudzenia)
+ *
+ *  @side effects:
+ *            Odcina zegary nieużywanych peryferiów (UART0/1, PWM1, I2C0/1, SPI, SSP0).
+ *            Tor audio zostaje aktywny - uśpienie dopiero przez power_sleep().
+ */
+void power_init(uint32_t (*clockUs)(void))
+{
+    getUs = clockUs;
+    asleep = false;
+    stats.sleeps = 0U;
+    stats.wakes = 0U;
+    stats.wakeUs = 0U;
+    stats.wakeMaxUs = 0U;
+    stats.rampMs = 0U;
+    stats.rampMaxMs = 0U;
+
+    CLKPWR_ConfigPPWR(POWER_UNUSED_PCONP, DISABLE);
+}
+
+/*!
+ *  @brief    Usypia tor audio na czas bezczynności albo pauzy.
+ *
+ *  @side effects:
+ *            Wymaga wyłączonego wcześniej Timer1. Ustawia DAC na środek,
+ *            wyłącza wzmacniacz (SHUTDN), przełącza DAC na prąd 350 uA
+ *            i odcina zegar Timer1.
+ */
+void power_sleep(void)
+{
+    if (asleep == true) {
+        return;
+    }
+
+    DAC_UpdateValue(LPC_DAC, POWER_DAC_MIDDLE);
+    amp_shutdown(true);
+    DAC_SetBias(LPC_DAC, DAC_MAX_CURRENT_350uA);
+    CLKPWR_ConfigPPWR(CLKPWR_PCONP_PCTIM1, DISABLE);
+
+    asleep = true;
+    stats.sleeps++;
+}
+
+/*!
+ *  @brief    Budzi tor audio przed startem albo wznowieniem odtwarzania.
+ *  @param nowMs
+ *            Aktualny czas w milisekundach (początek narastania)
+ *
+ *  @side effects:
+ *            Włącza zegar Timer1 (bez uruchamiania timera), przywraca prąd
+ *            DAC 700 uA i włącza wzmacniacz od najniższego kroku; narastanie
+ *            do ustawionej głośności prowadzi power_tick().
+ */
+void power_wake(uint32_t nowMs)
+{
+    uint32_t start;
+    uint32_t elapsed;
+
+    if (asleep == false) {
+        return;
+    }
+
+    start = getUs();
+    CLKPWR_ConfigPPWR(CLKPWR_PCONP_PCTIM1, ENABLE);
+    DAC_SetBias(LPC_DAC, DAC_MAX_CURRENT_700uA);
+    DAC_UpdateValue(LPC_DAC, POWER_DAC_MIDDLE);
+    amp_shutdown(false);
+    elapsed = getUs() - start;
+
+    asleep = false;
+    rampStartMs = nowMs;
+    stats.wakes++;
+    stats.wakeUs = elapsed;
+    if (elapsed > stats.wakeMaxUs) {
+        stats.wakeMaxUs = elapsed;
+    }
+}
+
+/*!
+ *  @brief    Krok okresowy, wywoływany co 1 ms.
+ *  @param nowMs
+ *            Aktualny czas w milisekundach
+ *
+ *  @side effects:
+ *            Prowadzi narastanie wzmocnienia i zapisuje jego czas w statystykach.
+ */
+void power_tick(uint32_t nowMs)
+{
+    uint32_t ramp;
+
+    if (amp_tick(nowMs) == true) {
+        ramp = nowMs - rampStartMs;
+        stats.rampMs = ramp;
+        if (ramp > stats.rampMaxMs) {
+            stats.rampMaxMs = ramp;
+        }
+    }
+}
+
+/*!
+ *  @brief    Sprawdza czy tor audio jest uśpiony.
+ *
+ *  @returns  true gdy wzmacniacz jest wyłączony, a Timer1 bez zegara
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+bool power_isAsleep(void)
+{
+    return asleep;
+}
+
+/*!
+ *  @brief    Zwraca statystyki uśpień i czasów wybudzenia.
+ *
+ *  @returns  Wskaźnik na statystyki modułu
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+PowerStats_t* power_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,24 @@
+#ifndef __POWER_H
+#define __POWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Statystyki do odczytu debuggerem */
+typedef struct {
+    uint32_t sleeps;
+    uint32_t wakes;
+    uint32_t wakeUs;        /* czas ostatniego wybudzenia toru audio */
+    uint32_t wakeMaxUs;
+    uint32_t rampMs;        /* czas ostatniego narastania wzmocnienia */
+    uint32_t rampMaxMs;
+} PowerStats_t;
+
+void power_init(uint32_t (*clockUs)(void));
+void power_sleep(void);
+void power_wake(uint32_t nowMs);
+void power_tick(uint32_t nowMs);
+bool power_isAsleep(void);
+PowerStats_t* power_stats(void);
+
+#endif /* __POWER_H */
@@ -0,0 +1,111 @@
+#include "quadrature.h"
+
+/*
+ * Automat pełnego kroku: licznik zmienia się dopiero po przejściu całej
+ * sekwencji 11 -> 01 -> 00 -> 10 -> 11 (lub odwrotnej) między zatrzaskami.
+ * Drgania styków i niedozwolone przejścia cofają automat bez zliczania.
+ */
+#define Q_START     0x0U
+#define Q_CW_FINAL  0x1U
+#define Q_CW_BEGIN  0x2U
+#define Q_CW_NEXT   0x3U
+#define Q_CCW_BEGIN 0x4U
+#define Q_CCW_FINAL 0x5U
+#define Q_CCW_NEXT  0x6U
+
+#define Q_DIR_CW  0x10U
+#define Q_DIR_CCW 0x20U
+#define Q_STATE_MASK 0x0FU
+
+/* Tablica przejść [stan][AB] */
+static const uint8_t transitions[7][4] = {
+    /* Q_START */     {Q_START,    Q_CW_BEGIN,  Q_CCW_BEGIN, Q_START},
+    /* Q_CW_FINAL */  {Q_CW_NEXT,  Q_START,     Q_CW_FINAL,  Q_START | Q_DIR_CW},
+    /* Q_CW_BEGIN */  {Q_CW_NEXT,  Q_CW_BEGIN,  Q_START,     Q_START},
+    /* Q_CW_NEXT */   {Q_CW_NEXT,  Q_CW_BEGIN,  Q_CW_FINAL,  Q_START},
+    /* Q_CCW_BEGIN */ {Q_CCW_NEXT, Q_START,     Q_CCW_BEGIN, Q_START},
+    /* Q_CCW_FINAL */ {Q_CCW_NEXT, Q_CCW_FINAL, Q_START,     Q_START | Q_DIR_CCW},
+    /* Q_CCW_NEXT */  {Q_CCW_NEXT, Q_CCW_FINAL, Q_CCW_BEGIN, Q_START}
+};
+
+/*!
+ *  @brief    Inicjalizuje dekoder.
+ *  @param q
+ *            Stan dekodera
+ *  @param ab
+ *            Aktualny stan linii: A na bicie 1, B na bicie 0
+ *
+ *  @side effects:
+ *            Zeruje licznik i statystyki.
+ */
+void quad_init(Quadrature_t* q, uint8_t ab)
+{
+    q->state = Q_START;
+    q->lastAB = ab & 3U;
+    q->count = 0;
+    q->lastRead = 0;
+    q->edges = 0U;
+    q->glitches = 0U;
+}
+
+/*!
+ *  @brief    Przetwarza nowy stan linii enkodera, wywoływana z przerwania GPIO.
+ *  @param q
+ *            Stan dekodera
+ *  @param ab
+ *            Stan linii odczytany po zboczu: A na bicie 1, B na bicie 0
+ *
+ *  @returns  +1 lub -1 po pełnym zatrzasku, 0 w pozostałych przypadkach
+ *  @side effects:
+ *            Zbocze po którym stan linii się nie zmienił (impuls krótszy niż
+ *            czas wejścia w przerwanie) jest liczone jako zakłócenie i pomijane.
+ *            Modyfikuje licznik zatrzasków.
+ */
+int8_t quad_update(Quadrature_t* q, uint8_t ab)
+{
+    uint8_t next;
+    int8_t dir = 0;
+
+    ab &= 3U;
+    q->edges++;
+    if (ab == q->lastAB) {
+        q->glitches++;
+        return 0;
+    }
+    q->lastAB = ab;
+
+    next = transitions[q->state & Q_STATE_MASK][ab];
+    q->state = next & Q_STATE_MASK;
+
+    if ((next & Q_DIR_CW) != 0U) {
+        dir = 1;
+    }
+    else if ((next & Q_DIR_CCW) != 0U) {
+        dir = -1;
+    }
+    else {
+        /* zatrzask jeszcze nie osiągnięty */
+    }
+    q->count += dir;
+    return dir;
+}
+
+/*!
+ *  @brief    Zwraca liczbę zatrzasków od poprzedniego wywołania, bez blokowania.
+ *  @param q
+ *            Stan dekodera
+ *
+ *  @returns  Zmiana licznika: dodatnia w prawo, ujemna w lewo
+ *  @side effects:
+ *            Licznik zapisuje tylko przerwanie GPIO, odczytujący (jeden) zapamiętuje
+ *            ostatnio odczytaną wartość - 32-bitowy odczyt jest atomowy, więc nie
+ *            trzeba blokować przerwań.
+ */
+int32_t quad_takeDelta(Quadrature_t* q)
+{
+    int32_t now = q->count;
+    int32_t delta = now - q->lastRead;
+
+    q->lastRead = now;
+    return delta;
+}
@@ -0,0 +1,20 @@
+#ifndef __QUADRATURE_H
+#define __QUADRATURE_H
+
+#include <stdint.h>
+
+/* Stan dekodera kwadraturowego enkodera obrotowego */
+typedef struct {
+    uint8_t state;              /* stan automatu, modyfikowany tylko w przerwaniu */
+    uint8_t lastAB;             /* ostatnio odczytane stany linii A (bit 1) i B (bit 0) */
+    volatile int32_t count;     /* licznik zatrzasków, zapisywany tylko w przerwaniu */
+    int32_t lastRead;           /* wartość licznika przy ostatnim odczycie */
+    volatile uint32_t edges;    /* liczba obsłużonych zboczy */
+    volatile uint32_t glitches; /* zbocza odrzucone jako zakłócenia */
+} Quadrature_t;
+
+void quad_init(Quadrature_t* q, uint8_t ab);
+int8_t quad_update(Quadrature_t* q, uint8_t ab);
+int32_t quad_takeDelta(Quadrature_t* q);
+
+#endif /* __QUADRATURE_H */
@@ -0,0 +1,214 @@
+#include <string.h>
+
+#include "resume.h"
+#include "eeprom.h"
+
+/* Układ rekordu na stronie EEPROM */
+#define REC_MAGIC 0x5AU
+#define REC_OFS_MAGIC 0U
+#define REC_OFS_SEQ 1U
+#define REC_OFS_TRACK 3U
+#define REC_OFS_HASH 5U
+#define REC_OFS_OFFSET 7U
+#define REC_OFS_VOLUME 11U
+#define REC_OFS_MODE 12U
+#define REC_OFS_PATH 13U    /* zero w rekordach sprzed obsługi katalogów - katalog główny */
+#define REC_OFS_CRC 15U
+
+static ResumeState_t written;       /* stan ostatnio zapisany albo wczytany */
+static ResumeState_t pending;
+static bool isPending = false;
+static uint16_t seq = 0U;
+static uint8_t slot = 0U;           /* strona następnego zapisu */
+static uint32_t lastWriteMs = 0U;
+
+static ResumeStats_t stats;
+
+/*!
+ *  @brief    CRC-8 (wielomian 0x07) z danych rekordu.
+ *
+ *  @returns  Suma kontrolna
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static uint8_t crc8(const uint8_t* p, uint32_t len)
+{
+    uint8_t crc = 0U;
+    uint32_t i;
+    uint8_t b;
+
+    for (i = 0U; i < len; i++) {
+        crc ^= p[i];
+        for (b = 0U; b < 8U; b++) {
+            crc = ((crc & 0x80U) != 0U) ? (uint8_t)((crc << 1) ^ 0x07U) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/*!
+ *  @brief    Porównuje dwa stany.
+ *
+ *  @returns  true gdy wszystkie pola są równe
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static bool same(const ResumeState_t* a, const ResumeState_t* b)
+{
+    return (a->track == b->track) && (a->nameHash == b->nameHash) && (a->offset == b->offset)
+        && (a->volume == b->volume) && (a->mode == b->mode) && (a->pathHash == b->pathHash);
+}
+
+/*!
+ *  @brief    Wczytuje najnowszy poprawny rekord stanu z pierścienia w EEPROM.
+ *  @param out
+ *            Wczytany stan
+ *
+ *  @returns  true jeśli znaleziono poprawny rekord
+ *  @side effects:
+ *            Blokujące odczyty I2C, wywoływana raz przy starcie.
+ *            Ustala stronę i numer kolejny następnego zapisu.
+ */
+bool resume_load(ResumeState_t* out)
+{
+    uint8_t rec[RESUME_REC_SIZE];
+    uint8_t i;
+    uint16_t s;
+    bool found = false;
+
+    stats.loads++;
+    for (i = 0U; i < RESUME_SLOTS; i++) {
+        if (eeprom_read(rec, (uint16_t)(RESUME_EE_BASE + (i * RESUME_REC_SIZE)), RESUME_REC_SIZE) < 0) {
+            stats.errors++;
+            continue;
+        }
+        if ((rec[REC_OFS_MAGIC] != REC_MAGIC) || (crc8(rec, REC_OFS_CRC) != rec[REC_OFS_CRC])) {
+            continue;
+        }
+        s = (uint16_t)(rec[REC_OFS_SEQ] | (rec[REC_OFS_SEQ + 1U] << 8));
+        /* najnowszy rekord: numer kolejny większy w arytmetyce modulo 2^16 */
+        if ((found == false) || ((int16_t)(s - seq) > 0)) {
+            found = true;
+            seq = s;
+            slot = (uint8_t)((i + 1U) % RESUME_SLOTS);
+            written.track = (uint16_t)(rec[REC_OFS_TRACK] | (rec[REC_OFS_TRACK + 1U] << 8));
+            written.nameHash = (uint16_t)(rec[REC_OFS_HASH] | (rec[REC_OFS_HASH + 1U] << 8));
+            written.offset = (uint32_t)rec[REC_OFS_OFFSET] | ((uint32_t)rec[REC_OFS_OFFSET + 1U] << 8)
+                | ((uint32_t)rec[REC_OFS_OFFSET + 2U] << 16) | ((uint32_t)rec[REC_OFS_OFFSET + 3U] << 24);
+            written.volume = rec[REC_OFS_VOLUME];
+            written.mode = rec[REC_OFS_MODE];
+            written.pathHash = (uint16_t)(rec[REC_OFS_PATH] | (rec[REC_OFS_PATH + 1U] << 8));
+        }
+    }
+
+    if (found == true) {
+        *out = written;
+    }
+    isPending = false;
+    stats.seq = seq;
+    stats.slot = slot;
+    return found;
+}
+
+/*!
+ *  @brief    Zgłasza stan do zapisu.
+ *  @param st
+ *            Stan do zapisania
+ *
+ *  @side effects:
+ *            Tylko kopiuje stan; zapis wykonuje resume_task(). Stan równy
+ *            ostatnio zapisanemu nie jest zapisywany ponownie.
+ */
+void resume_save(const ResumeState_t* st)
+{
+    if (same(st, &written) == true) {
+        isPending = false;
+        stats.unchanged++;
+        return;
+    }
+    pending = *st;
+    isPending = true;
+}
+
+/*!
+ *  @brief    Krok zapisu, wywoływany z zadania okresowego.
+ *  @param nowMs
+ *            Aktualny czas w milisekundach
+ *
+ *  @side effects:
+ *            Najwyżej raz na RESUME_GAP_MS kolejkuje zapis jednej strony
+ *            (rekord mieści się na stronie), bez czekania na I2C i cykl zapisu.
+ */
+void resume_task(uint32_t nowMs)
+{
+    uint8_t rec[RESUME_REC_SIZE];
+
+    if ((isPending == false) || ((nowMs - lastWriteMs) < RESUME_GAP_MS)) {
+        return;
+    }
+
+    seq++;
+    (void)memset(rec, 0, sizeof(rec));
+    rec[REC_OFS_MAGIC] = REC_MAGIC;
+    rec[REC_OFS_SEQ] = (uint8_t)seq;
+    rec[REC_OFS_SEQ + 1U] = (uint8_t)(seq >> 8);
+    rec[REC_OFS_TRACK] = (uint8_t)pending.track;
+    rec[REC_OFS_TRACK + 1U] = (uint8_t)(pending.track >> 8);
+    rec[REC_OFS_HASH] = (uint8_t)pending.nameHash;
+    rec[REC_OFS_HASH + 1U] = (uint8_t)(pending.nameHash >> 8);
+    rec[REC_OFS_OFFSET] = (uint8_t)pending.offset;
+    rec[REC_OFS_OFFSET + 1U] = (uint8_t)(pending.offset >> 8);
+    rec[REC_OFS_OFFSET + 2U] = (uint8_t)(pending.offset >> 16);
+    rec[REC_OFS_OFFSET + 3U] = (uint8_t)(pending.offset >> 24);
+    rec[REC_OFS_VOLUME] = pending.volume;
+    rec[REC_OFS_MODE] = pending.mode;
+    rec[REC_OFS_PATH] = (uint8_t)pending.pathHash;
+    rec[REC_OFS_PATH + 1U] = (uint8_t)(pending.pathHash >> 8);
+    rec[REC_OFS_CRC] = crc8(rec, REC_OFS_CRC);
+
+    if (eeprom_writePage(rec, (uint16_t)(RESUME_EE_BASE + (slot * RESUME_REC_SIZE)), RESUME_REC_SIZE) < 0) {
+        stats.errors++;
+    }
+    else {
+        written = pending;
+        stats.saves++;
+    }
+    slot = (uint8_t)((slot + 1U) % RESUME_SLOTS);
+    isPending = false;
+    lastWriteMs = nowMs;
+    stats.seq = seq;
+    stats.slot = slot;
+}
+
+/*!
+ *  @brief    Skrót nazwy pliku (FNV-1a złożony do 16 bitów).
+ *  @param name
+ *            Nazwa pliku
+ *
+ *  @returns  16-bitowy skrót
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+uint16_t resume_hash(const char* name)
+{
+    uint32_t h = 2166136261UL;
+
+    while (*name != '\0') {
+        h ^= (uint8_t)*name;
+        h *= 16777619UL;
+        name++;
+    }
+    return (uint16_t)(h ^ (h >> 16));
+}
+
+/*!
+ *  @brief    Zwraca statystyki zapisu stanu.
+ *
+ *  @returns  Wskaźnik na statystyki modułu
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+ResumeStats_t* resume_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,46 @@
+#ifndef __RESUME_H
+#define __RESUME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Pierścień rekordów stanu w ostatnim bloku EEPROM 24LC08 (0x300-0x3FF):
+   16 stron po 16 bajtów, każdy zapis trafia na następną stronę */
+#define RESUME_EE_BASE 0x300U
+#define RESUME_SLOTS 16U
+#define RESUME_REC_SIZE 16U
+
+/* Zapis okresowy w trakcie odtwarzania i minimalny odstęp między zapisami */
+#define RESUME_PERIOD_MS 30000U
+#define RESUME_GAP_MS 20U
+
+/* Bity pola mode */
+#define RESUME_MODE_XFADE_MASK 0x0FU    /* długość przejścia w sekundach */
+#define RESUME_MODE_SPECTRUM 0x10U      /* widok analizatora */
+
+typedef struct {
+    uint16_t track;         /* numer utworu na liście */
+    uint16_t nameHash;      /* skrót nazwy - sprawdzenie, czy lista się nie zmieniła */
+    uint16_t pathHash;      /* skrót ścieżki katalogu utworu, 0 - katalog główny */
+    uint32_t offset;        /* pozycja w danych PCM w bajtach */
+    uint8_t volume;
+    uint8_t mode;
+} ResumeState_t;
+
+/* Statystyki do odczytu debuggerem */
+typedef struct {
+    uint32_t loads;
+    uint32_t saves;         /* rekordy zapisane do EEPROM */
+    uint32_t unchanged;     /* żądania pominięte, bo stan się nie zmienił */
+    uint32_t errors;
+    uint16_t seq;
+    uint8_t slot;
+} ResumeStats_t;
+
+bool resume_load(ResumeState_t* out);
+void resume_save(const ResumeState_t* st);
+void resume_task(uint32_t nowMs);
+uint16_t resume_hash(const char* name);
+ResumeStats_t* resume_stats(void);
+
+#endif /* __RESUME_H */
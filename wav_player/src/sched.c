@@ -0,0 +1,169 @@
+#include "LPC17xx.h"
+#include "sched.h"
+
+static SchedTask tasks[SCHED_MAX_TASKS];
+
+/*
+ * Flaga budzenia na zadanie. Zapis bajtu jest atomowy, więc przerwania
+ * ustawiają flagę bez blokowania, a pętla zeruje ją przed wykonaniem zadania -
+ * sygnał, który przyjdzie w trakcie zadania, uruchomi je ponownie.
+ */
+static volatile uint8_t pending[SCHED_MAX_TASKS];
+
+static uint32_t (*getUs)(void) = 0;
+static SchedStats_t stats;
+static uint32_t windowUs = 0U;
+
+/*!
+ *  @brief    Inicjalizuje planistę.
+ *  @param clockUs
+ *            Funkcja zwracająca czas w mikrosekundach, używana do statystyk
+ *
+ *  @side effects:
+ *            Usuwa wszystkie zadania i zeruje statystyki.
+ */
+void sched_init(uint32_t (*clockUs)(void))
+{
+    uint8_t i;
+
+    for (i = 0U; i < SCHED_MAX_TASKS; i++) {
+        tasks[i] = 0;
+        pending[i] = 0U;
+    }
+    getUs = clockUs;
+    stats.busyPasses = 0U;
+    stats.idlePasses = 0U;
+    stats.busyUs = 0U;
+    stats.idleUs = 0U;
+    stats.loadPct = 0U;
+    stats.maxTaskUs = 0U;
+    windowUs = 0U;
+}
+
+/*!
+ *  @brief    Rejestruje zadanie.
+ *  @param id
+ *            Numer zadania, mniejszy = wyższy priorytet
+ *  @param task
+ *            Funkcja wykonywana do końca po każdym sygnale
+ *
+ *  @side effects:
+ *            Brak
+ */
+void sched_add(uint8_t id, SchedTask task)
+{
+    if (id < SCHED_MAX_TASKS) {
+        tasks[id] = task;
+    }
+}
+
+/*!
+ *  @brief    Budzi zadanie, można wywoływać z przerwań.
+ *  @param id
+ *            Numer zadania
+ *
+ *  @side effects:
+ *            Kilka sygnałów przed wykonaniem zadania daje jedno wykonanie.
+ */
+void sched_signal(uint8_t id)
+{
+    if (id < SCHED_MAX_TASKS) {
+        pending[id] = 1U;
+    }
+}
+
+/*!
+ *  @brief    Zwraca najpilniejsze zadanie z ustawioną flagą.
+ *
+ *  @returns  Numer zadania albo SCHED_MAX_TASKS gdy nic nie czeka
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static uint8_t next_pending(void)
+{
+    uint8_t i;
+
+    for (i = 0U; i < SCHED_MAX_TASKS; i++) {
+        if ((pending[i] != 0U) && (tasks[i] != 0)) {
+            return i;
+        }
+    }
+    return SCHED_MAX_TASKS;
+}
+
+/*!
+ *  @brief    Dolicza czas przebiegu do okna pomiaru obciążenia.
+ *
+ *  @side effects:
+ *            Po zamknięciu okna wylicza loadPct i zaczyna nowe okno.
+ */
+static void account(uint32_t us, uint8_t busy)
+{
+    if (busy != 0U) {
+        stats.busyUs += us;
+    }
+    else {
+        stats.idleUs += us;
+    }
+    windowUs += us;
+    if (windowUs >= SCHED_LOAD_WINDOW_US) {
+        stats.loadPct = (uint32_t)(((uint64_t)stats.busyUs * 100U) / windowUs);
+        stats.busyUs = 0U;
+        stats.idleUs = 0U;
+        windowUs = 0U;
+    }
+}
+
+/*!
+ *  @brief    Pętla planisty, nie wraca.
+ *
+ *  @side effects:
+ *            W każdym przebiegu wykonuje jedno zadanie o najwyższym priorytecie,
+ *            więc pilne zadanie czeka najwyżej na koniec bieżącego.
+ *            Gdy nic nie czeka, usypia rdzeń instrukcją __WFI. Flagi sprawdzane są
+ *            przy zablokowanych przerwaniach - przerwanie zgłoszone tuż przed
+ *            uśpieniem i tak wybudzi rdzeń, a jego obsługa nastąpi po __enable_irq.
+ *            Czas obsługi przerwania budzącego liczony jest do bezczynności.
+ */
+void sched_run(void)
+{
+    uint8_t id;
+    uint32_t start;
+    uint32_t elapsed;
+
+    for (;;) {
+        start = getUs();
+        id = next_pending();
+        if (id < SCHED_MAX_TASKS) {
+            pending[id] = 0U;
+            tasks[id]();
+            elapsed = getUs() - start;
+            stats.busyPasses++;
+            if (elapsed > stats.maxTaskUs) {
+                stats.maxTaskUs = elapsed;
+            }
+            account(elapsed, 1U);
+        }
+        else {
+            __disable_irq();
+            if (next_pending() == SCHED_MAX_TASKS) {
+                __WFI();
+            }
+            __enable_irq();
+            stats.idlePasses++;
+            account(getUs() - start, 0U);
+        }
+    }
+}
+
+/*!
+ *  @brief    Zwraca statystyki planisty.
+ *
+ *  @returns  Wskaźnik na statystyki
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+const SchedStats_t* sched_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,30 @@
+#ifndef __SCHED_H
+#define __SCHED_H
+
+#include <stdint.h>
+
+/* Maksymalna liczba zadań; numer zadania jest jednocześnie priorytetem (0 najwyższy) */
+#define SCHED_MAX_TASKS 8U
+
+/* Okno pomiaru obciążenia procesora */
+#define SCHED_LOAD_WINDOW_US 1000000U
+
+typedef void (*SchedTask)(void);
+
+/* Statystyki do odczytu debuggerem */
+typedef struct {
+    uint32_t busyPasses;    /* przebiegi, w których wykonano zadanie */
+    uint32_t idlePasses;    /* przebiegi zakończone uśpieniem (__WFI) */
+    uint32_t busyUs;        /* czas w zadaniach i przerwaniach w bieżącym oknie */
+    uint32_t idleUs;        /* czas uśpienia w bieżącym oknie */
+    uint32_t loadPct;       /* obciążenie w ostatnim pełnym oknie */
+    uint32_t maxTaskUs;     /* najdłuższe pojedyncze wykonanie zadania */
+} SchedStats_t;
+
+void sched_init(uint32_t (*clockUs)(void));
+void sched_add(uint8_t id, SchedTask task);
+void sched_signal(uint8_t id);
+void sched_run(void);
+const SchedStats_t* sched_stats(void);
+
+#endif /* __SCHED_H */
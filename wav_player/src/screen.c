@@ -0,0 +1,90 @@
+#include "screen.h"
+#include "ui.h"
+#include <stdio.h>
+#include <string.h>
+
+/*!
+ *  @brief    Ustawia wiersze listy utworów z oznaczeniem wybranego utworu.
+ *  @param current
+ *            Numer wybranego utworu
+ *  @param nameAt
+ *            Funkcja zwracająca nazwę utworu o danym numerze albo NULL za końcem listy
+ *
+ *  @side effects:
+ *            Ustawia wiersze listy w modelu ekranu, rysowanie odbywa się w ui_task().
+ *            Wybrany utwór jest oznaczony symbolem ">" i odwróconymi kolorami.
+ *            Zbyt długa nazwa wybranego utworu jest przewijana sprzętowo przez sterownik OLED.
+ */
+void screen_list(int32_t current, const char* (*nameAt)(int32_t index))
+{
+    int32_t i;
+    int32_t first = 0;
+    int32_t track;
+    const char* name;
+    char line[UI_ROW_LEN + 1U];
+
+    /* Okno listy przesuwane tak, aby zaznaczony utwór był widoczny */
+    if (current >= (int32_t)SCREEN_LIST_ROWS) {
+        first = current - (int32_t)SCREEN_LIST_ROWS + 1;
+    }
+
+    for (i = 0; i < (int32_t)SCREEN_LIST_ROWS; i++) {
+        track = first + i;
+        name = nameAt(track);
+        if (name == NULL) {
+            ui_setRow((uint8_t)i, "", OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
+        }
+        else if (track == current) {
+            /* Wyróżnienie aktualnego utworu */
+            (void)snprintf(line, sizeof(line), "> %s", name);
+            ui_setRow((uint8_t)i, line, OLED_COLOR_WHITE, OLED_COLOR_BLACK,
+                strlen(name) > SCREEN_LIST_VISIBLE_CHARS);
+        }
+        else {
+            (void)snprintf(line, sizeof(line), "  %s", name);
+            ui_setRow((uint8_t)i, line, OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
+        }
+    }
+}
+
+/*!
+ *  @brief    Ustawia czas odtwarzania i pasek postępu.
+ *  @param played
+ *            Odtworzone bajty danych PCM
+ *  @param dataSize
+ *            Rozmiar danych PCM w bajtach
+ *  @param bytesPerSec
+ *            Bajty danych na sekundę odtwarzania
+ *
+ *  @side effects:
+ *            Ustawia wiersz statusu na "mm:ss/mm:ss" (czas odtworzony / całkowity,
+ *            najwyżej 99:59) i pasek postępu z dokładnością do jednej kolumny ekranu.
+ *            ui_task() wysyła potem tylko zmienione cyfry i kolumny paska.
+ */
+void screen_progress(uint32_t played, uint32_t dataSize, uint32_t bytesPerSec)
+{
+    char msg[UI_ROW_LEN + 1U];
+    uint32_t elapsed;
+    uint32_t total;
+    uint8_t fill;
+
+    if ((bytesPerSec == 0U) || (dataSize == 0U)) {
+        return;
+    }
+
+    elapsed = played / bytesPerSec;
+    total = dataSize / bytesPerSec;
+    if (elapsed > SCREEN_TIME_MAX_S) {
+        elapsed = SCREEN_TIME_MAX_S;
+    }
+    if (total > SCREEN_TIME_MAX_S) {
+        total = SCREEN_TIME_MAX_S;
+    }
+    fill = (uint8_t)(((uint64_t)played * OLED_DISPLAY_WIDTH) / dataSize);
+
+    (void)snprintf(msg, sizeof(msg), "%02lu:%02lu/%02lu:%02lu",
+        (unsigned long)(elapsed / 60U), (unsigned long)(elapsed % 60U),
+        (unsigned long)(total / 60U), (unsigned long)(total % 60U));
+    ui_setRow(SCREEN_STATUS_ROW, msg, OLED_COLOR_BLACK, OLED_COLOR_WHITE, false);
+    ui_setBar(SCREEN_PROGRESS_ROW, fill);
+}
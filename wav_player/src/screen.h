@@ -0,0 +1,16 @@
+#ifndef __SCREEN_H
+#define __SCREEN_H
+
+#include <stdint.h>
+
+/* Układ ekranu odtwarzacza */
+#define SCREEN_LIST_ROWS 6U             /* wiersze 0-5 ekranu zajmuje lista */
+#define SCREEN_LIST_VISIBLE_CHARS 14U   /* znaki nazwy widoczne za znacznikiem "> " */
+#define SCREEN_STATUS_ROW 6U            /* komunikaty i czas odtwarzania */
+#define SCREEN_PROGRESS_ROW 7U
+#define SCREEN_TIME_MAX_S (99U * 60U + 59U)  /* 99:59, dwie cyfry minut w wierszu statusu */
+
+void screen_list(int32_t current, const char* (*nameAt)(int32_t index));
+void screen_progress(uint32_t played, uint32_t dataSize, uint32_t bytesPerSec);
+
+#endif /* __SCREEN_H */
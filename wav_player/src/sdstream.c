@@ -0,0 +1,154 @@
+#include <string.h>
+
+#include "sdstream.h"
+
+static SdStreamStats_t stats;
+
+/*!
+ *  @brief    Wiąże strumień z otwartym plikiem.
+ *  @param s
+ *            Strumień
+ *  @param fp
+ *            Plik ustawiony na pozycji, od której ma być czytany
+ *
+ *  @side effects:
+ *            Porzuca dane w buforze; wywoływana po otwarciu pliku i po f_lseek.
+ */
+void sds_attach(SdStream_t* s, FIL* fp)
+{
+    s->fp = fp;
+    s->rd = 0U;
+    s->full = 0U;
+    s->pos = 0U;
+}
+
+/*!
+ *  @brief    Doczytuje do wolnego miejsca w buforze dane do najbliższej granicy sektora.
+ *
+ *  @returns  Wynik f_read
+ *  @side effects:
+ *            Na granicy sektora f_read czyta cały sektor prosto do bufora strumienia,
+ *            bez wspólnego okna systemu plików (poza tablicą FAT na granicy
+ *            klastra). Krótszy odczyt zdarza się tylko po otwarciu (nagłówek
+ *            WAV ma 44 bajty) albo przewinięciu. Na końcu pliku nic nie dodaje.
+ */
+static FRESULT refill(SdStream_t* s)
+{
+    uint8_t slot = (uint8_t)((s->rd + s->full) % SDS_SLOTS);
+    UINT want = SDS_SECTOR_SIZE - (UINT)(s->fp->fptr % SDS_SECTOR_SIZE);
+    UINT br = 0U;
+    FRESULT res;
+
+    if (want == SDS_SECTOR_SIZE) {
+        stats.sectors++;
+    }
+    else {
+        stats.partial++;
+    }
+    res = f_read(s->fp, s->sec[slot], want, &br);
+    s->len[slot] = (uint16_t)br;
+    if ((res == FR_OK) && (br > 0U)) {
+        s->full++;
+    }
+    return res;
+}
+
+/*!
+ *  @brief    Czyta dane ze strumienia.
+ *  @param s
+ *            Strumień związany z plikiem przez sds_attach()
+ *  @param dst
+ *            Bufor na dane
+ *  @param len
+ *            Liczba bajtów do odczytania
+ *  @param br
+ *            Zwracana liczba odczytanych bajtów, mniejsza na końcu pliku
+ *
+ *  @returns  FR_OK albo błąd f_read
+ *  @side effects:
+ *            Czyta z karty tylko gdy w buforze zabraknie danych. Wskaźnik pliku
+ *            wyprzedza dane oddane przez strumień najwyżej o SDS_SLOTS sektorów.
+ */
+FRESULT sds_read(SdStream_t* s, uint8_t* dst, uint32_t len, uint32_t* br)
+{
+    uint32_t n;
+    FRESULT res = FR_OK;
+
+    *br = 0U;
+    while (*br < len) {
+        if (s->full == 0U) {
+            res = refill(s);
+            if ((res != FR_OK) || (s->full == 0U)) {
+                break;
+            }
+        }
+        n = (uint32_t)(s->len[s->rd] - s->pos);
+        if (n > (len - *br)) {
+            n = len - *br;
+        }
+        (void)memcpy(&dst[*br], &s->sec[s->rd][s->pos], n);
+        s->pos = (uint16_t)(s->pos + n);
+        *br += n;
+        if (s->pos >= s->len[s->rd]) {
+            s->rd = (uint8_t)((s->rd + 1U) % SDS_SLOTS);
+            s->full--;
+            s->pos = 0U;
+        }
+    }
+    return res;
+}
+
+/*!
+ *  @brief    Doczytuje jeden sektor z wyprzedzeniem, jeśli jest na niego miejsce.
+ *  @param s
+ *            Strumień
+ *
+ *  @returns  true jeśli odczytano dane z karty
+ *  @side effects:
+ *            Wywoływana po doczytaniu połówki bufora audio, żeby następne
+ *            doczytanie nie musiało czekać na kartę.
+ */
+bool sds_topUp(SdStream_t* s)
+{
+    uint8_t before = s->full;
+
+    if ((s->fp == NULL) || (s->full >= SDS_SLOTS) || (s->fp->fptr >= s->fp->fsize)) {
+        return false;
+    }
+    (void)refill(s);
+    if (s->full > before) {
+        stats.ahead++;
+        return true;
+    }
+    return false;
+}
+
+/*!
+ *  @brief    Liczba bajtów w buforze strumienia.
+ *
+ *  @returns  Bajty gotowe do oddania bez odczytu z karty
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+uint32_t sds_buffered(const SdStream_t* s)
+{
+    uint32_t n = 0U;
+    uint8_t i;
+
+    for (i = 0U; i < s->full; i++) {
+        n += s->len[(s->rd + i) % SDS_SLOTS];
+    }
+    return n - s->pos;
+}
+
+/*!
+ *  @brief    Zwraca statystyki odczytów strumieni.
+ *
+ *  @returns  Wskaźnik na statystyki modułu
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+const SdStreamStats_t* sds_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,41 @@
+#ifndef __SDSTREAM_H
+#define __SDSTREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ff.h"
+
+/* Odczyt strumienia PCM całymi sektorami do prywatnego bufora. Przy _FS_TINY
+   odczyt części sektora idzie przez wspólne okno fs->win, więc dwa pliki
+   czytane na przemian po 256 bajtów (przejście między utworami) ładowałyby
+   ten sam sektor kilka razy; odczyt od granicy sektora omija okno. */
+#define SDS_SECTOR_SIZE _MAX_SS
+
+/* Sektory w buforze strumienia: czytany i doczytany z wyprzedzeniem, który
+   pokrywa chwilowe opóźnienie karty */
+#define SDS_SLOTS 2U
+
+typedef struct {
+    FIL* fp;
+    uint8_t rd;             /* sektor, z którego oddawane są dane */
+    uint8_t full;           /* sektory z danymi */
+    uint16_t pos;           /* następny bajt do oddania z sektora rd */
+    uint16_t len[SDS_SLOTS];
+    uint8_t sec[SDS_SLOTS][SDS_SECTOR_SIZE];
+} SdStream_t;
+
+/* Statystyki do odczytu debuggerem */
+typedef struct {
+    uint32_t sectors;       /* odczyty pełnych sektorów z pominięciem okna */
+    uint32_t partial;       /* odczyty do granicy sektora po otwarciu albo przewinięciu */
+    uint32_t ahead;         /* sektory doczytane z wyprzedzeniem przez sds_topUp() */
+} SdStreamStats_t;
+
+void sds_attach(SdStream_t* s, FIL* fp);
+FRESULT sds_read(SdStream_t* s, uint8_t* dst, uint32_t len, uint32_t* br);
+bool sds_topUp(SdStream_t* s);
+uint32_t sds_buffered(const SdStream_t* s);
+const SdStreamStats_t* sds_stats(void);
+
+#endif /* __SDSTREAM_H */
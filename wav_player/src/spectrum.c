@@ -0,0 +1,313 @@
+#include "spectrum.h"
+#include "fft.h"
+#include "oled.h"
+#include <string.h>
+
+#define SPECTRUM_HEIGHT (SPECTRUM_ROWS * 8U)
+#define SPECTRUM_DECAY_PX 2U
+
+/* Granice pasm w skali logarytmicznej dla 256 punktów (128 prążków) */
+static const uint8_t bandEdges256[SPECTRUM_BARS + 1U] = {
+    1U, 1U, 2U, 2U, 3U, 5U, 6U, 8U, 11U, 15U, 21U, 28U, 38U, 51U, 69U, 94U, 128U
+};
+
+static int16_t fftRe[SPECTRUM_N];
+static int16_t fftIm[SPECTRUM_N];
+static uint8_t bandEdges[SPECTRUM_BARS + 1U];
+
+/* Wysokości słupków: docelowe i aktualnie narysowane */
+static uint8_t barTarget[SPECTRUM_BARS];
+static uint8_t barDrawn[SPECTRUM_BARS];
+
+static uint32_t (*getUs)(void) = 0;
+static volatile bool wantBlock = false;
+static volatile bool blockReady = false;
+static uint32_t fill = 0U;
+static uint32_t lastFrameMs = 0U;
+static uint32_t frameCost = 0U;
+
+static SpectrumStats_t stats;
+
+/*!
+ *  @brief    Logarytm o podstawie 2 z dwoma bitami części ułamkowej.
+ *
+ *  @returns  uint32_t z wartością 4*log2(v)
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static uint32_t log2_q2(uint32_t v)
+{
+    uint32_t l = 0U;
+
+    if (v == 0U) {
+        return 0U;
+    }
+    while ((v >> l) > 1U) {
+        l++;
+    }
+    /* dwa bity po najstarszej jedynce */
+    if (l >= 2U) {
+        return (l << 2) | ((v >> (l - 2U)) & 3U);
+    }
+    return (l << 2) | ((v << (2U - l)) & 3U);
+}
+
+/*!
+ *  @brief    Zwraca bajt kolumny słupka w danej stronie wyświetlacza.
+ *
+ *  @returns  uint8_t, bit 0 to górny wiersz strony, 0 = piksel słupka (czarny)
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static uint8_t bar_page_byte(uint8_t height, uint8_t page)
+{
+    uint32_t top = SPECTRUM_HEIGHT - height;
+    uint32_t first = (uint32_t)page * 8U;
+
+    if (top <= first) {
+        return 0x00U;
+    }
+    if (top >= (first + 8U)) {
+        return 0xFFU;
+    }
+    return (uint8_t)((1U << (top - first)) - 1U);
+}
+
+/*!
+ *  @brief    Rysuje jeden słupek, przesyłając tylko strony które się zmieniły.
+ *
+ *  @side effects:
+ *            Transmisja do wyświetlacza: najwyżej SPECTRUM_ROWS x (3 + SPECTRUM_BAR_WIDTH) bajtów.
+ */
+static void draw_bar(uint8_t bar)
+{
+    uint8_t page;
+    uint8_t old;
+    uint8_t cur;
+    uint8_t cols[SPECTRUM_BAR_WIDTH];
+
+    for (page = 0U; page < SPECTRUM_ROWS; page++) {
+        old = bar_page_byte(barDrawn[bar], page);
+        cur = bar_page_byte(barTarget[bar], page);
+        if (old != cur) {
+            (void)memset(cols, cur, sizeof(cols));
+            oled_putColumns((uint8_t)(bar * (SPECTRUM_BAR_WIDTH + 1U)), (uint8_t)(page * 8U), cols, SPECTRUM_BAR_WIDTH);
+        }
+    }
+    barDrawn[bar] = barTarget[bar];
+}
+
+/*!
+ *  @brief    Liczy FFT z zebranego bloku i wyznacza docelowe wysokości słupków.
+ *
+ *  @side effects:
+ *            Modyfikuje bufory FFT i barTarget.
+ */
+static void analyse_block(void)
+{
+    uint32_t b;
+    uint32_t k;
+    uint32_t m;
+    uint32_t peak;
+    uint32_t h;
+
+    fft_window(fftRe, SPECTRUM_LOG2N);
+    (void)memset(fftIm, 0, sizeof(fftIm));
+    fft_q15(fftRe, fftIm, SPECTRUM_LOG2N);
+
+    for (b = 0U; b < SPECTRUM_BARS; b++) {
+        peak = 0U;
+        for (k = bandEdges[b]; k < bandEdges[b + 1U]; k++) {
+            m = fft_mag(fftRe[k], fftIm[k]);
+            if (m > peak) {
+                peak = m;
+            }
+        }
+
+        /* 4 piksele na oktawę (6 dB), poziomy poniżej 8 pomijane */
+        h = log2_q2(peak);
+        h = (h > 12U) ? (h - 12U) : 0U;
+        if (h > SPECTRUM_HEIGHT) {
+            h = SPECTRUM_HEIGHT;
+        }
+
+        /* Powolne opadanie słupków */
+        if ((h + SPECTRUM_DECAY_PX) < barTarget[b]) {
+            h = barTarget[b] - SPECTRUM_DECAY_PX;
+        }
+        barTarget[b] = (uint8_t)h;
+    }
+}
+
+/*!
+ *  @brief    Dostosowuje odstęp między klatkami do zmierzonego kosztu klatki.
+ *
+ *  @side effects:
+ *            Modyfikuje stats.intervalMs i stats.throttled.
+ */
+static void adjust_rate(void)
+{
+    uint32_t budgetUs = (stats.intervalMs * 1000U * SPECTRUM_CPU_BUDGET_PCT) / 100U;
+
+    if ((frameCost > budgetUs) && (stats.intervalMs < SPECTRUM_MAX_INTERVAL_MS)) {
+        stats.intervalMs <<= 1;
+        stats.throttled++;
+    }
+    else if (((frameCost * 4U) < budgetUs) && (stats.intervalMs > SPECTRUM_MIN_INTERVAL_MS)) {
+        stats.intervalMs >>= 1;
+    }
+    else {
+        /* koszt mieści się w budżecie */
+    }
+}
+
+/*!
+ *  @brief    Inicjalizuje analizator widma.
+ *  @param clockUs
+ *            Funkcja zwracająca czas w mikrosekundach, używana do pomiaru kosztu
+ *
+ *  @side effects:
+ *            Wyznacza granice pasm dla SPECTRUM_N punktów i zeruje statystyki.
+ */
+void spectrum_init(uint32_t (*clockUs)(void))
+{
+    uint32_t b;
+    uint32_t e;
+    uint32_t shift = FFT_MAX_LOG2N - SPECTRUM_LOG2N;
+
+    getUs = clockUs;
+
+    for (b = 0U; b <= SPECTRUM_BARS; b++) {
+        e = (uint32_t)bandEdges256[b] >> shift;
+        if ((b > 0U) && (e <= bandEdges[b - 1U])) {
+            e = bandEdges[b - 1U] + 1U;
+        }
+        if (e < 1U) {
+            e = 1U;     /* bez składowej stałej */
+        }
+        if (e > (SPECTRUM_N / 2U)) {
+            e = SPECTRUM_N / 2U;
+        }
+        bandEdges[b] = (uint8_t)e;
+    }
+
+    (void)memset(&stats, 0, sizeof(stats));
+    stats.intervalMs = SPECTRUM_MIN_INTERVAL_MS;
+    spectrum_reset();
+}
+
+/*!
+ *  @brief    Zeruje stan wizualizacji przy wejściu na ekran widma.
+ *
+ *  @side effects:
+ *            Zakłada, że obszar słupków na ekranie jest pusty (biały).
+ */
+void spectrum_reset(void)
+{
+    (void)memset(barTarget, 0, sizeof(barTarget));
+    (void)memset(barDrawn, 0, sizeof(barDrawn));
+    fill = 0U;
+    blockReady = false;
+    wantBlock = true;
+    frameCost = 0U;
+}
+
+/*!
+ *  @brief    Przekazuje świeżo odczytany blok próbek do analizy.
+ *  @param pcm
+ *            Próbki 16-bit little-endian, mono
+ *  @param len
+ *            Długość bloku w bajtach
+ *
+ *  @side effects:
+ *            Kopiuje próbki tylko gdy analizator czeka na nowy blok,
+ *            w pozostałych przypadkach kończy działanie od razu. Blok
+ *            zbierany jest z kolejnych wywołań, po SPECTRUM_DECIMATION
+ *            próbek uśrednianych w jedną.
+ */
+void spectrum_feed(const uint8_t* pcm, uint32_t len)
+{
+    uint32_t i;
+    uint32_t d;
+    int32_t acc;
+
+    if ((wantBlock == false) || (blockReady == true)) {
+        return;
+    }
+
+    for (i = 0U; ((i + (2U * SPECTRUM_DECIMATION)) <= len) && (fill < SPECTRUM_N); i += 2U * SPECTRUM_DECIMATION) {
+        acc = 0;
+        for (d = 0U; d < SPECTRUM_DECIMATION; d++) {
+            acc += (int16_t)(pcm[i + (2U * d)] | (pcm[i + (2U * d) + 1U] << 8));
+        }
+        fftRe[fill] = (int16_t)(acc / (int32_t)SPECTRUM_DECIMATION);
+        fill++;
+    }
+
+    if (fill >= SPECTRUM_N) {
+        fill = 0U;
+        wantBlock = false;
+        blockReady = true;
+    }
+}
+
+/*!
+ *  @brief    Wykonuje jeden krok pracy analizatora.
+ *  @param nowMs
+ *            Aktualny czas w milisekundach
+ *
+ *  @returns  true jeśli została wykonana praca (FFT albo rysowanie słupka)
+ *  @side effects:
+ *            W jednym wywołaniu liczy FFT albo rysuje jeden słupek.
+ *            Mierzy koszt klatki i w razie potrzeby zmniejsza liczbę klatek na sekundę.
+ */
+bool spectrum_task(uint32_t nowMs)
+{
+    uint32_t start = getUs();
+    uint32_t elapsed;
+    uint8_t b;
+
+    if (blockReady == true) {
+        adjust_rate();
+        frameCost = 0U;
+
+        analyse_block();
+        blockReady = false;
+        lastFrameMs = nowMs;
+
+        elapsed = getUs() - start;
+        frameCost += elapsed;
+        stats.frames++;
+        stats.fftUs = elapsed;
+        if (elapsed > stats.fftMaxUs) {
+            stats.fftMaxUs = elapsed;
+        }
+        return true;
+    }
+
+    for (b = 0U; b < SPECTRUM_BARS; b++) {
+        if (barDrawn[b] != barTarget[b]) {
+            draw_bar(b);
+            frameCost += getUs() - start;
+            stats.frameCostUs = frameCost;
+            return true;
+        }
+    }
+
+    if ((wantBlock == false) && ((nowMs - lastFrameMs) >= stats.intervalMs)) {
+        wantBlock = true;
+    }
+    return false;
+}
+
+/*!
+ *  @brief    Zwraca statystyki analizatora.
+ *
+ *  @returns  Wskaźnik na strukturę statystyk
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+const SpectrumStats_t* spectrum_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,41 @@
+#ifndef __SPECTRUM_H
+#define __SPECTRUM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Rozmiar FFT: 2^7 = 128 punktów, tyle ile próbek w połówce bufora */
+#define SPECTRUM_LOG2N 7U
+#define SPECTRUM_N (1U << SPECTRUM_LOG2N)
+
+/* Decymacja próbek przed FFT (średnia z par): 128 punktów z 256 próbek 8 kHz,
+   pasmo 0-2 kHz co 31 Hz, blok z dwóch połówek bufora */
+#define SPECTRUM_DECIMATION 2U
+
+/* Wizualizacja zajmuje wiersze 0-5 ekranu */
+#define SPECTRUM_BARS 16U
+#define SPECTRUM_BAR_WIDTH 5U
+#define SPECTRUM_ROWS 6U
+
+/* Limit czasu procesora: analiza sama zmniejsza liczbę klatek na sekundę */
+#define SPECTRUM_CPU_BUDGET_PCT 10U
+#define SPECTRUM_MIN_INTERVAL_MS 40U
+#define SPECTRUM_MAX_INTERVAL_MS 640U
+
+/* Statystyki do odczytu debuggerem */
+typedef struct {
+    uint32_t frames;
+    uint32_t fftUs;
+    uint32_t fftMaxUs;
+    uint32_t frameCostUs;
+    uint32_t intervalMs;
+    uint32_t throttled;
+} SpectrumStats_t;
+
+void spectrum_init(uint32_t (*clockUs)(void));
+void spectrum_reset(void);
+void spectrum_feed(const uint8_t* pcm, uint32_t len);
+bool spectrum_task(uint32_t nowMs);
+const SpectrumStats_t* spectrum_stats(void);
+
+#endif /* __SPECTRUM_H */
@@ -0,0 +1,336 @@
+#include "ui.h"
+#include <string.h>
+
+/* Rodzaj zawartości wiersza */
+typedef enum {
+    ROW_TEXT = 0,
+    ROW_BAR
+} UiRowKind;
+
+/* Stan jednego wiersza ekranu */
+typedef struct {
+    UiRowKind kind;
+    char text[UI_ROW_LEN + 1U];
+    oled_color_t fg;
+    oled_color_t bg;
+    bool scroll;
+    uint8_t barFill;
+} UiRow;
+
+#define UI_ALL_ROWS ((1U << UI_ROWS) - 1U)
+#define UI_NO_SCROLL 0xFFU
+
+/* Znaki widoczne na ekranie: 96 kolumn / 6 */
+#define UI_VISIBLE_CHARS (OLED_DISPLAY_WIDTH / 6U)
+
+/* Powyżej tylu zmienionych znaków taniej jest wysłać cały wiersz (9 vs 135 bajtów) */
+#define UI_MAX_CHAR_UPDATES 8U
+
+/* Kolumny paska postępu: wypełniona i pusta (ramka), bit 0 = górny wiersz, 0 = czarny */
+#define UI_BAR_FILLED 0xC3U
+#define UI_BAR_EMPTY  0xDBU
+
+/* Stan żądany i stan narysowany na ekranie */
+static UiRow rows[UI_ROWS];
+static UiRow drawn[UI_ROWS];
+
+/* Maska wierszy do przerysowania, bit n = wiersz n */
+static uint8_t dirtyRows = 0U;
+
+/* Maska wierszy których zawartość na ekranie jest nieznana */
+static uint8_t invalidRows = 0U;
+
+/* Wiersz przewijany sprzętowo przez sterownik lub UI_NO_SCROLL */
+static uint8_t scrollRow = UI_NO_SCROLL;
+
+/*!
+ *  @brief    Inicjalizuje model ekranu.
+ *
+ *  @side effects:
+ *            Oznacza wszystkie wiersze do przerysowania, żeby nadpisać
+ *            to co zostało na ekranie po komunikatach startowych.
+ */
+void ui_init(void)
+{
+    uint8_t i;
+
+    for (i = 0U; i < UI_ROWS; i++) {
+        rows[i].kind = ROW_TEXT;
+        rows[i].text[0] = '\0';
+        rows[i].fg = OLED_COLOR_BLACK;
+        rows[i].bg = OLED_COLOR_WHITE;
+        rows[i].scroll = false;
+        rows[i].barFill = 0U;
+    }
+    dirtyRows = UI_ALL_ROWS;
+    invalidRows = UI_ALL_ROWS;
+    scrollRow = UI_NO_SCROLL;
+}
+
+/*!
+ *  @brief    Ustawia zawartość wiersza ekranu.
+ *  @param row
+ *            Numer wiersza (0 - UI_ROWS-1)
+ *  @param text
+ *            Tekst wiersza, dłuższy niż UI_ROW_LEN jest obcinany
+ *  @param fg
+ *            Kolor tekstu
+ *  @param bg
+ *            Kolor tła
+ *  @param scroll
+ *            true jeśli wiersz ma być przewijany sprzętowo
+ *
+ *  @side effects:
+ *            Oznacza wiersz do przerysowania tylko gdy jego zawartość się zmieniła.
+ *            Nie wykonuje żadnej transmisji do wyświetlacza.
+ */
+void ui_setRow(uint8_t row, const char* text, oled_color_t fg, oled_color_t bg, bool scroll)
+{
+    UiRow* r;
+
+    if (row >= UI_ROWS) {
+        return;
+    }
+
+    r = &rows[row];
+    if ((r->kind == ROW_TEXT) && (strncmp(r->text, text, UI_ROW_LEN) == 0)
+        && (r->fg == fg) && (r->bg == bg) && (r->scroll == scroll)) {
+        return;
+    }
+
+    r->kind = ROW_TEXT;
+    (void)strncpy(r->text, text, UI_ROW_LEN);
+    r->text[UI_ROW_LEN] = '\0';
+    r->fg = fg;
+    r->bg = bg;
+    r->scroll = scroll;
+    dirtyRows |= (uint8_t)(1U << row);
+}
+
+/*!
+ *  @brief    Ustawia wiersz jako pasek postępu.
+ *  @param row
+ *            Numer wiersza (0 - UI_ROWS-1)
+ *  @param fill
+ *            Liczba wypełnionych kolumn (0 - OLED_DISPLAY_WIDTH)
+ *
+ *  @side effects:
+ *            Oznacza wiersz do przerysowania tylko gdy zmieniła się liczba kolumn.
+ */
+void ui_setBar(uint8_t row, uint8_t fill)
+{
+    UiRow* r;
+
+    if (row >= UI_ROWS) {
+        return;
+    }
+    if (fill > OLED_DISPLAY_WIDTH) {
+        fill = OLED_DISPLAY_WIDTH;
+    }
+
+    r = &rows[row];
+    if ((r->kind == ROW_BAR) && (r->barFill == fill)) {
+        return;
+    }
+
+    r->kind = ROW_BAR;
+    r->text[0] = '\0';
+    r->fg = OLED_COLOR_BLACK;
+    r->bg = OLED_COLOR_WHITE;
+    r->scroll = false;
+    r->barFill = fill;
+    dirtyRows |= (uint8_t)(1U << row);
+}
+
+/*!
+ *  @brief    Czyści cały ekran podanym kolorem.
+ *  @param color
+ *            Kolor tła
+ *
+ *  @side effects:
+ *            Ustawia wszystkie wiersze jako puste, czyszczenie odbywa się
+ *            wiersz po wierszu w kolejnych wywołaniach ui_task().
+ */
+void ui_clear(oled_color_t color)
+{
+    uint8_t i;
+    oled_color_t fg = (color == OLED_COLOR_WHITE) ? OLED_COLOR_BLACK : OLED_COLOR_WHITE;
+
+    for (i = 0U; i < UI_ROWS; i++) {
+        ui_setRow(i, "", fg, color, false);
+    }
+}
+
+/*!
+ *  @brief    Oznacza wiersze jako nieznane na ekranie.
+ *  @param first
+ *            Pierwszy wiersz
+ *  @param last
+ *            Ostatni wiersz
+ *
+ *  @side effects:
+ *            Wiersze zostaną przerysowane w całości, np. po rysowaniu po nich
+ *            bezpośrednio przez sterownik OLED.
+ */
+void ui_invalidate(uint8_t first, uint8_t last)
+{
+    uint8_t i;
+
+    for (i = first; (i <= last) && (i < UI_ROWS); i++) {
+        invalidRows |= (uint8_t)(1U << i);
+        dirtyRows |= (uint8_t)(1U << i);
+    }
+}
+
+/*!
+ *  @brief    Sprawdza czy są wiersze oczekujące na przerysowanie.
+ *
+ *  @returns  true jeśli ui_task() ma coś do zrobienia
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+bool ui_pending(void)
+{
+    return (dirtyRows != 0U);
+}
+
+/*!
+ *  @brief    Przerysowuje tylko zmienione znaki wiersza tekstowego.
+ *
+ *  @returns  true jeśli udało się zaktualizować wiersz znak po znaku,
+ *            false jeśli trzeba wysłać cały wiersz
+ *  @side effects:
+ *            Wysyła 9 bajtów na każdy zmieniony znak.
+ */
+static bool update_chars(uint8_t row)
+{
+    UiRow* r = &rows[row];
+    UiRow* d = &drawn[row];
+    uint8_t i;
+    uint8_t changes = 0U;
+    bool endR = false;
+    bool endD = false;
+    char cr;
+    char cd;
+
+    if (((invalidRows & (1U << row)) != 0U) || (d->kind != ROW_TEXT) || (d->scroll == true)
+        || (r->scroll == true) || (d->fg != r->fg) || (d->bg != r->bg)) {
+        return false;
+    }
+
+    /* Zliczenie zmian, znaki poza ekranem wymagają zapisu całego wiersza */
+    for (i = 0U; i < UI_ROW_LEN; i++) {
+        endR = endR || (r->text[i] == '\0');
+        endD = endD || (d->text[i] == '\0');
+        cr = endR ? ' ' : r->text[i];
+        cd = endD ? ' ' : d->text[i];
+        if (cr != cd) {
+            if (i >= UI_VISIBLE_CHARS) {
+                return false;
+            }
+            changes++;
+        }
+    }
+    if (changes > UI_MAX_CHAR_UPDATES) {
+        return false;
+    }
+
+    endR = false;
+    endD = false;
+    for (i = 0U; i < UI_VISIBLE_CHARS; i++) {
+        endR = endR || (r->text[i] == '\0');
+        endD = endD || (d->text[i] == '\0');
+        cr = endR ? ' ' : r->text[i];
+        cd = endD ? ' ' : d->text[i];
+        if (cr != cd) {
+            (void)oled_putCharLine((uint8_t)(i * 6U), (uint8_t)(row * UI_ROW_HEIGHT), (uint8_t)cr, r->fg, r->bg);
+        }
+    }
+    return true;
+}
+
+/*!
+ *  @brief    Rysuje pasek postępu, wysyłając tylko kolumny które się zmieniły.
+ *
+ *  @side effects:
+ *            Wysyła 3 komendy i po jednym bajcie na każdą zmienioną kolumnę.
+ */
+static void update_bar(uint8_t row)
+{
+    UiRow* r = &rows[row];
+    UiRow* d = &drawn[row];
+    uint8_t cols[OLED_DISPLAY_WIDTH];
+    uint8_t from = 0U;
+    uint8_t to = OLED_DISPLAY_WIDTH;
+    uint8_t i;
+
+    if (((invalidRows & (1U << row)) == 0U) && (d->kind == ROW_BAR)) {
+        from = (d->barFill < r->barFill) ? d->barFill : r->barFill;
+        to = (d->barFill < r->barFill) ? r->barFill : d->barFill;
+    }
+
+    for (i = from; i < to; i++) {
+        cols[i - from] = (i < r->barFill) ? UI_BAR_FILLED : UI_BAR_EMPTY;
+    }
+    if (to > from) {
+        oled_putColumns(from, (uint8_t)(row * UI_ROW_HEIGHT), cols, (uint8_t)(to - from));
+    }
+}
+
+/*!
+ *  @brief    Wykonuje jeden krok rysowania interfejsu.
+ *
+ *  @returns  true jeśli została wykonana transmisja do wyświetlacza
+ *  @side effects:
+ *            Przerysowuje co najwyżej jeden wiersz (najwyżej jedna strona, 3 komendy + 132 bajty danych)
+ *            albo zatrzymuje przewijanie wiersza który ma zostać zmieniony.
+ *            Z wiersza wysyłane są tylko zmienione znaki lub kolumny, jeśli to możliwe.
+ *            Czas jednego kroku jest ograniczony niezależnie od ilości zmian na ekranie.
+ */
+bool ui_task(void)
+{
+    uint8_t row;
+    UiRow* r;
+
+    if (dirtyRows == 0U) {
+        return false;
+    }
+
+    for (row = 0U; (dirtyRows & (1U << row)) == 0U; row++) {
+        /* szukanie pierwszego wiersza do przerysowania */
+    }
+
+    /* Przewijanie modyfikuje pamięć sterownika, najpierw trzeba je zatrzymać */
+    if (scrollRow == row) {
+        oled_scrollStop();
+        scrollRow = UI_NO_SCROLL;
+        invalidRows |= (uint8_t)(1U << row);
+        return true;
+    }
+
+    r = &rows[row];
+    if (r->kind == ROW_BAR) {
+        update_bar(row);
+    }
+    else if (update_chars(row) == false) {
+        (void)oled_putStringLine((uint8_t)(row * UI_ROW_HEIGHT), (uint8_t*)r->text, r->fg, r->bg);
+        if (r->scroll == true) {
+            oled_scrollHorizontal((uint8_t)(row * UI_ROW_HEIGHT), (uint8_t)(row * UI_ROW_HEIGHT),
+                OLED_SCROLL_LEFT, OLED_SCROLL_6_FRAMES);
+            if ((scrollRow != UI_NO_SCROLL) && (scrollRow != row)) {
+                /* poprzednio przewijany wiersz został odtworzony bez tekstu spoza ekranu */
+                invalidRows |= (uint8_t)(1U << scrollRow);
+            }
+            scrollRow = row;
+        }
+    }
+    else {
+        /* zaktualizowane tylko zmienione znaki */
+    }
+
+    drawn[row] = *r;
+    dirtyRows &= (uint8_t)~(1U << row);
+    invalidRows &= (uint8_t)~(1U << row);
+
+    return true;
+}
@@ -0,0 +1,21 @@
+#ifndef __UI_H
+#define __UI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "oled.h"
+
+/* Ekran podzielony na wiersze tekstu o wysokości jednej strony sterownika (8 px) */
+#define UI_ROWS 8U
+#define UI_ROW_HEIGHT 8U
+#define UI_ROW_LEN 22U      /* szerokość pamięci sterownika: 132 kolumny / 6 */
+
+void ui_init(void);
+void ui_setRow(uint8_t row, const char* text, oled_color_t fg, oled_color_t bg, bool scroll);
+void ui_setBar(uint8_t row, uint8_t fill);
+void ui_clear(oled_color_t color);
+void ui_invalidate(uint8_t first, uint8_t last);
+bool ui_pending(void);
+bool ui_task(void);
+
+#endif /* __UI_H */
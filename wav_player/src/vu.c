@@ -0,0 +1,243 @@
+#include "vu.h"
+
+/* log2(1 + i/16) * 256 */
+static const uint16_t log2Frac[17] = {
+    0U, 22U, 44U, 63U, 82U, 100U, 118U, 134U, 150U,
+    165U, 179U, 193U, 207U, 220U, 232U, 244U, 256U
+};
+
+static uint32_t (*getUs)(void) = 0;
+
+/* Akumulatory bieżącej ramki, wypełniane po doczytaniu bufora */
+static uint32_t sumSq = 0U;     /* suma (x/16)^2 */
+static uint32_t count = 0U;
+static uint32_t peakAbs = 0U;
+
+static uint32_t shown = 0U;
+static uint32_t peak = 0U;
+static uint32_t peakUntil = 0U;
+static uint32_t lastFrameMs = 0U;
+
+static VuStats_t stats;
+
+/*!
+ *  @brief    Pierwiastek całkowity.
+ *
+ *  @returns  floor(sqrt(v))
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static uint32_t isqrt(uint32_t v)
+{
+    uint32_t res = 0U;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0U) {
+        if (v >= (res + bit)) {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return res;
+}
+
+/*!
+ *  @brief    Logarytm o podstawie 2 z 8 bitami części ułamkowej (tablica i interpolacja).
+ *
+ *  @returns  256*log2(v), 0 dla v <= 1
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static uint32_t log2_q8(uint32_t v)
+{
+    uint32_t e = 0U;
+    uint32_t m;
+    uint32_t i;
+
+    if (v <= 1U) {
+        return 0U;
+    }
+    while ((v >> e) > 1U) {
+        e++;
+    }
+    /* mantysa w zakresie 256-511 */
+    m = (e >= 8U) ? (v >> (e - 8U)) : (v << (8U - e));
+    i = (m - 256U) >> 4;
+    return (e << 8) + log2Frac[i] + (((log2Frac[i + 1U] - log2Frac[i]) * (m & 15U)) >> 4);
+}
+
+/*!
+ *  @brief    Zamienia amplitudę próbki 16-bit na poziom linijki.
+ *
+ *  @returns  Poziom 0-VU_LEVEL_MAX, górna dioda to pełna skala
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static uint32_t to_level(uint32_t amp)
+{
+    /* 32767 ~ 2^15: pełna linijka; każda dioda niżej to -6 dB */
+    uint32_t l = log2_q8(amp);
+    uint32_t floorQ8 = (15U - VU_LEDS) * 256U;
+
+    if (l <= floorQ8) {
+        return 0U;
+    }
+    l -= floorQ8;
+    return (l > VU_LEVEL_MAX) ? VU_LEVEL_MAX : l;
+}
+
+/*!
+ *  @brief    Inicjalizuje miernik wysterowania.
+ *  @param clockUs
+ *            Funkcja zwracająca czas w mikrosekundach, używana do statystyk
+ *
+ *  @side effects:
+ *            Zeruje wskazania i statystyki.
+ */
+void vu_init(uint32_t (*clockUs)(void))
+{
+    getUs = clockUs;
+    vu_reset();
+    stats.blocks = 0U;
+    stats.feedUs = 0U;
+    stats.feedMaxUs = 0U;
+    stats.frames = 0U;
+    stats.frameUs = 0U;
+    stats.i2cBytes = 0U;
+    stats.i2cMaxBytes = 0U;
+}
+
+/*!
+ *  @brief    Zeruje wskazania po zmianie utworu, przewinięciu albo pauzie.
+ *
+ *  @side effects:
+ *            Następna ramka liczona jest tylko z nowych próbek, bez starego szczytu.
+ */
+void vu_reset(void)
+{
+    sumSq = 0U;
+    count = 0U;
+    peakAbs = 0U;
+    shown = 0U;
+    peak = 0U;
+    peakUntil = 0U;
+}
+
+/*!
+ *  @brief    Dolicza blok próbek PCM do bieżącej ramki.
+ *  @param pcm
+ *            Dane 16-bit little-endian mono
+ *  @param len
+ *            Długość w bajtach
+ *
+ *  @side effects:
+ *            Aktualizuje sumę kwadratów i szczyt ramki; próbki skalowane /16,
+ *            aby suma zmieściła się w 32 bitach dla kilku bloków.
+ */
+void vu_feed(const uint8_t* pcm, uint32_t len)
+{
+    uint32_t start = getUs();
+    uint32_t i;
+    int32_t x;
+    uint32_t a;
+    uint32_t s;
+
+    for (i = 0U; (i + 1U) < len; i += 2U) {
+        x = (int16_t)((uint16_t)pcm[i] | ((uint16_t)pcm[i + 1U] << 8));
+        a = (x < 0) ? (uint32_t)(-x) : (uint32_t)x;
+        if (a > peakAbs) {
+            peakAbs = a;
+        }
+        s = a >> 4;
+        /* nasycenie zamiast przepełnienia przy długiej ramce */
+        if (sumSq <= (0xFFFFFFFFUL - (s * s))) {
+            sumSq += s * s;
+            count++;
+        }
+    }
+
+    stats.blocks++;
+    stats.feedUs = getUs() - start;
+    if (stats.feedUs > stats.feedMaxUs) {
+        stats.feedMaxUs = stats.feedUs;
+    }
+}
+
+/*!
+ *  @brief    Wylicza wskazanie linijki raz na VU_FRAME_MS.
+ *  @param nowMs
+ *            Aktualny czas w milisekundach
+ *  @param out
+ *            Poziom RMS i dioda szczytu
+ *
+ *  @returns  true jeśli zaczęła się nowa ramka i out jest wypełnione
+ *  @side effects:
+ *            Szybki wzrost, opadanie o VU_RELEASE_Q8 na ramkę. Szczyt trzymany
+ *            VU_PEAK_HOLD_MS, potem opada. Zeruje akumulatory ramki.
+ */
+bool vu_frame(uint32_t nowMs, VuFrame_t* out)
+{
+    uint32_t start;
+    uint32_t rms = 0U;
+    uint32_t level;
+    uint32_t pk;
+
+    if ((nowMs - lastFrameMs) < VU_FRAME_MS) {
+        return false;
+    }
+    lastFrameMs = nowMs;
+    start = getUs();
+
+    if (count > 0U) {
+        rms = isqrt(sumSq / count) << 4;
+    }
+    level = to_level(rms);
+    pk = to_level(peakAbs);
+    sumSq = 0U;
+    count = 0U;
+    peakAbs = 0U;
+
+    if (level >= shown) {
+        shown = level;
+    }
+    else {
+        shown = ((shown - level) > VU_RELEASE_Q8) ? (shown - VU_RELEASE_Q8) : level;
+    }
+
+    if (pk >= peak) {
+        peak = pk;
+        peakUntil = nowMs + VU_PEAK_HOLD_MS;
+    }
+    else if ((int32_t)(nowMs - peakUntil) >= 0) {
+        peak = (peak > VU_PEAK_DECAY_Q8) ? (peak - VU_PEAK_DECAY_Q8) : 0U;
+    }
+    else {
+        /* trzymanie szczytu */
+    }
+
+    out->level = shown;
+    out->peakLed = (peak >= 256U) ? (uint8_t)((peak - 1U) >> 8) : VU_NO_PEAK;
+
+    stats.frames++;
+    stats.frameUs = getUs() - start;
+    return true;
+}
+
+/*!
+ *  @brief    Zwraca statystyki miernika.
+ *
+ *  @returns  Wskaźnik na statystyki; pola i2c uzupełnia wywołujący po zapisie linijki
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+VuStats_t* vu_stats(void)
+{
+    return &stats;
+}
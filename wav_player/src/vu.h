@@ -0,0 +1,42 @@
+#ifndef __VU_H
+#define __VU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Linijka: 8 diod po 6 dB (1 bit log2), poziom w 1/256 diody */
+#define VU_LEDS 8U
+#define VU_LEVEL_MAX (VU_LEDS * 256U)
+#define VU_NO_PEAK 0xFFU
+
+/* Ramki około 30 Hz */
+#define VU_FRAME_MS 33U
+
+/* Opadanie wskazania i wskaźnika szczytu, w 1/256 diody na ramkę */
+#define VU_RELEASE_Q8 96U
+#define VU_PEAK_HOLD_MS 600U
+#define VU_PEAK_DECAY_Q8 48U
+
+typedef struct {
+    uint32_t level;     /* poziom RMS, 0-VU_LEVEL_MAX */
+    uint8_t peakLed;    /* dioda wskaźnika szczytu albo VU_NO_PEAK */
+} VuFrame_t;
+
+/* Statystyki do odczytu debuggerem */
+typedef struct {
+    uint32_t blocks;
+    uint32_t feedUs;
+    uint32_t feedMaxUs;
+    uint32_t frames;
+    uint32_t frameUs;
+    uint32_t i2cBytes;      /* bajty zapisane do linijki w ostatniej ramce */
+    uint32_t i2cMaxBytes;
+} VuStats_t;
+
+void vu_init(uint32_t (*clockUs)(void));
+void vu_reset(void);
+void vu_feed(const uint8_t* pcm, uint32_t len);
+bool vu_frame(uint32_t nowMs, VuFrame_t* out);
+VuStats_t* vu_stats(void);
+
+#endif /* __VU_H */
@@ -0,0 +1,155 @@
+#include "xfade.h"
+
+/* sin(i/64 * pi/2) * 32767; wzmocnienie wygaszanego strumienia to wartość z drugiego końca */
+static const uint16_t curve[XFADE_CURVE_STEPS + 1U] = {
+    0U, 804U, 1608U, 2410U, 3212U, 4011U, 4808U, 5602U, 6393U, 7179U, 7962U, 8739U, 9512U,
+    10278U, 11039U, 11793U, 12539U, 13279U, 14010U, 14732U, 15446U, 16151U, 16846U, 17530U,
+    18204U, 18868U, 19519U, 20159U, 20787U, 21403U, 22005U, 22594U, 23170U, 23731U, 24279U,
+    24811U, 25329U, 25832U, 26319U, 26790U, 27245U, 27683U, 28105U, 28510U, 28898U, 29268U,
+    29621U, 29956U, 30273U, 30571U, 30852U, 31113U, 31356U, 31580U, 31785U, 31971U, 32137U,
+    32285U, 32412U, 32521U, 32609U, 32678U, 32728U, 32757U, 32767U
+};
+
+static uint32_t (*getUs)(void) = 0;
+
+static XfadeStats_t stats;
+
+/*!
+ *  @brief    Wartość krzywej z interpolacją liniową.
+ *  @param q8
+ *            Położenie na krzywej, 0 - XFADE_CURVE_STEPS*256
+ *
+ *  @returns  Wzmocnienie Q15
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+static int32_t curve_at(uint32_t q8)
+{
+    uint32_t i = q8 >> 8;
+    uint32_t f = q8 & 0xFFU;
+
+    if (i >= XFADE_CURVE_STEPS) {
+        return (int32_t)curve[XFADE_CURVE_STEPS];
+    }
+    return (int32_t)curve[i] + ((((int32_t)curve[i + 1U] - (int32_t)curve[i]) * (int32_t)f) >> 8);
+}
+
+/*!
+ *  @brief    Inicjalizuje mikser przejść.
+ *  @param clockUs
+ *            Funkcja zwracająca czas w mikrosekundach, używana do statystyk
+ *
+ *  @side effects:
+ *            Zeruje statystyki.
+ */
+void xfade_init(uint32_t (*clockUs)(void))
+{
+    getUs = clockUs;
+    stats.fades = 0U;
+    stats.chunks = 0U;
+    stats.mixUs = 0U;
+    stats.mixMaxUs = 0U;
+    stats.clipped = 0U;
+}
+
+/*!
+ *  @brief    Odnotowuje początek przejścia.
+ *
+ *  @side effects:
+ *            Zwiększa licznik przejść w statystykach.
+ */
+void xfade_begin(void)
+{
+    stats.fades++;
+}
+
+/*!
+ *  @brief    Miesza fragment dwóch strumieni krzywymi równej mocy.
+ *  @param out
+ *            Dane wygaszanego strumienia, 16-bit little-endian; nadpisywane wynikiem
+ *  @param in
+ *            Dane narastającego strumienia, ta sama długość
+ *  @param len
+ *            Długość w bajtach
+ *  @param pos
+ *            Położenie fragmentu w przejściu, w bajtach od jego początku
+ *  @param total
+ *            Długość całego przejścia w bajtach (najwyżej XFADE_MAX_S sekund)
+ *
+ *  @side effects:
+ *            Wzmocnienia liczone z krzywej na brzegach fragmentu i interpolowane
+ *            liniowo po próbkach z 8 bitami części ułamkowej kroku, bez skoku
+ *            na granicy fragmentów; suma obcinana do zakresu 16 bitów.
+ *            q1 nie przekracza końca krzywej, bo pos + len <= total.
+ */
+void xfade_mix(uint8_t* out, const uint8_t* in, uint32_t len, uint32_t pos, uint32_t total)
+{
+    uint32_t start = getUs();
+    uint32_t n = len / 2U;
+    uint32_t q0;
+    uint32_t q1;
+    int32_t gIn;
+    int32_t gInStep;
+    int32_t gOut;
+    int32_t gOutStep;
+    int32_t a;
+    int32_t b;
+    int32_t mix;
+    uint32_t i;
+    uint32_t elapsed;
+
+    if ((n == 0U) || (total == 0U)) {
+        return;
+    }
+
+    /* położenie na krzywej w 1/256 odcinka; pos * 16384 mieści się w 32 bitach dla 10 s */
+    q0 = (pos * (XFADE_CURVE_STEPS * 256U)) / total;
+    q1 = ((pos + len) * (XFADE_CURVE_STEPS * 256U)) / total;
+    /* wzmocnienia Q15 przesunięte o 8 bitów, żeby krok nie tracił reszty z dzielenia */
+    gIn = curve_at(q0) << 8;
+    gInStep = ((curve_at(q1) << 8) - gIn) / (int32_t)n;
+    /* cos(x) = sin(pi/2 - x) z tej samej krzywej */
+    gOut = curve_at((XFADE_CURVE_STEPS * 256U) - q0) << 8;
+    gOutStep = ((curve_at((XFADE_CURVE_STEPS * 256U) - q1) << 8) - gOut) / (int32_t)n;
+
+    for (i = 0U; i < n; i++) {
+        a = (int16_t)(out[2U * i] | (out[(2U * i) + 1U] << 8));
+        b = (int16_t)(in[2U * i] | (in[(2U * i) + 1U] << 8));
+        mix = ((a * (gOut >> 8)) + (b * (gIn >> 8))) >> 15;
+
+        if (mix > 32767) {
+            mix = 32767;
+            stats.clipped++;
+        }
+        else if (mix < -32768) {
+            mix = -32768;
+            stats.clipped++;
+        }
+        else {
+            /* w zakresie */
+        }
+        out[2U * i] = (uint8_t)mix;
+        out[(2U * i) + 1U] = (uint8_t)((uint32_t)mix >> 8);
+        gIn += gInStep;
+        gOut += gOutStep;
+    }
+
+    elapsed = getUs() - start;
+    stats.chunks++;
+    stats.mixUs = elapsed;
+    if (elapsed > stats.mixMaxUs) {
+        stats.mixMaxUs = elapsed;
+    }
+}
+
+/*!
+ *  @brief    Zwraca statystyki miksera.
+ *
+ *  @returns  Wskaźnik na statystyki modułu
+ *  @side effects:
+ *            Brak efektów ubocznych
+ */
+XfadeStats_t* xfade_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,29 @@
+#ifndef __XFADE_H
+#define __XFADE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Długość przejścia między utworami w sekundach, 0 = bez przejścia (same przejście bez przerwy);
+   ustawiana przytrzymanym środkowym przyciskiem i enkoderem */
+#define XFADE_MAX_S 10U
+#define XFADE_DEFAULT_S 0U
+
+/* Krzywa równej mocy: ćwiartka sinusa w 64 odcinkach, wartości Q15 */
+#define XFADE_CURVE_STEPS 64U
+
+/* Statystyki do odczytu debuggerem */
+typedef struct {
+    uint32_t fades;
+    uint32_t chunks;
+    uint32_t mixUs;         /* czas ostatniego bloku */
+    uint32_t mixMaxUs;
+    uint32_t clipped;       /* próbki obcięte do zakresu 16 bitów */
+} XfadeStats_t;
+
+void xfade_init(uint32_t (*clockUs)(void));
+void xfade_begin(void);
+void xfade_mix(uint8_t* out, const uint8_t* in, uint32_t len, uint32_t pos, uint32_t total);
+XfadeStats_t* xfade_stats(void);
+
+#endif /* __XFADE_H */